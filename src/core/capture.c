@@ -0,0 +1,338 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Capture file format: the magic string, then for each stanza a 9 bytes
+ * header (big endian length of the XML, '<' for a received stanza or '>'
+ * for a sent one, big endian milliseconds since the beginning of the
+ * capture) followed by the XML in UTF-8, without any terminator.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "module.h"
+#include "commands.h"
+#include "misc.h"
+#include "signals.h"
+
+#include "xmpp-servers.h"
+#include "xmpp-commands.h"
+#include "capture.h"
+#include "keywords.h"
+#include "stanzas.h"
+
+#define CAPTURE_MAGIC		"IXMPPCAP"
+#define CAPTURE_MAGIC_LEN	8
+#define CAPTURE_HEADER_LEN	9
+
+struct replay_parser {
+	LmMessage	*lmsg;
+	GSList		*nodes;
+	GSList		*values;
+	gboolean	 skip;
+};
+
+static FILE *capture_file;
+static gint64 capture_start;
+
+static void
+put_uint32(unsigned char *buf, guint32 value)
+{
+	buf[0] = (value >> 24) & 0xff;
+	buf[1] = (value >> 16) & 0xff;
+	buf[2] = (value >> 8) & 0xff;
+	buf[3] = value & 0xff;
+}
+
+static guint32
+get_uint32(const unsigned char *buf)
+{
+	return ((guint32)buf[0] << 24) | ((guint32)buf[1] << 16)
+	    | ((guint32)buf[2] << 8) | (guint32)buf[3];
+}
+
+void
+capture_stanza(XMPP_SERVER_REC *server, const char *xml, int out)
+{
+	unsigned char header[CAPTURE_HEADER_LEN];
+	size_t len;
+
+	if (capture_file == NULL || server->replaying)
+		return;
+	len = strlen(xml);
+	put_uint32(header, len);
+	header[4] = out ? '>' : '<';
+	put_uint32(header + 5,
+	    (g_get_monotonic_time() - capture_start) / 1000);
+	if (fwrite(header, CAPTURE_HEADER_LEN, 1, capture_file) != 1
+	    || fwrite(xml, len, 1, capture_file) != 1) {
+		g_warning("Stanza capture failed: %s", g_strerror(errno));
+		fclose(capture_file);
+		capture_file = NULL;
+	}
+}
+
+static LmMessageSubType
+get_sub_type(LmMessageType type, const char *str)
+{
+	int sub_type;
+
+	if ((sub_type = xmpp_keyword(XMPP_KEYWORDS_TYPE, str, -1)) != -1)
+		return sub_type;
+	/* the defaults of loudmouth's parser */
+	switch (type) {
+	case LM_MESSAGE_TYPE_PRESENCE:
+		return LM_MESSAGE_SUB_TYPE_AVAILABLE;
+	case LM_MESSAGE_TYPE_IQ:
+		return LM_MESSAGE_SUB_TYPE_GET;
+	default:
+		return LM_MESSAGE_SUB_TYPE_NOT_SET;
+	}
+}
+
+static void
+replay_start_element(GMarkupParseContext *context, const char *name,
+    const char **attr_names, const char **attr_values, gpointer user_data,
+    GError **error)
+{
+	struct replay_parser *rp;
+	LmMessageNode *node;
+	LmMessageType type;
+	const char *sub_type;
+	int i;
+
+	rp = user_data;
+	if (rp->skip)
+		return;
+	if (rp->lmsg == NULL) {
+		if (strcmp(name, "message") == 0)
+			type = LM_MESSAGE_TYPE_MESSAGE;
+		else if (strcmp(name, "presence") == 0)
+			type = LM_MESSAGE_TYPE_PRESENCE;
+		else if (strcmp(name, "iq") == 0)
+			type = LM_MESSAGE_TYPE_IQ;
+		else {
+			/* stanzas without any handler */
+			rp->skip = TRUE;
+			return;
+		}
+		sub_type = NULL;
+		for (i = 0; attr_names[i] != NULL; ++i)
+			if (strcmp(attr_names[i], "type") == 0)
+				sub_type = attr_values[i];
+		rp->lmsg = lm_message_new_with_sub_type(NULL, type,
+		    get_sub_type(type, sub_type));
+		node = rp->lmsg->node;
+	} else
+		node = lm_message_node_add_child(rp->nodes->data, name, NULL);
+	for (i = 0; attr_names[i] != NULL; ++i)
+		lm_message_node_set_attribute(node, attr_names[i],
+		    attr_values[i]);
+	rp->nodes = g_slist_prepend(rp->nodes, node);
+	rp->values = g_slist_prepend(rp->values, NULL);
+}
+
+static void
+replay_end_element(GMarkupParseContext *context, const char *name,
+    gpointer user_data, GError **error)
+{
+	struct replay_parser *rp;
+	GString *value;
+
+	rp = user_data;
+	if (rp->skip || rp->nodes == NULL)
+		return;
+	if ((value = rp->values->data) != NULL) {
+		lm_message_node_set_value(rp->nodes->data, value->str);
+		g_string_free(value, TRUE);
+	}
+	rp->nodes = g_slist_delete_link(rp->nodes, rp->nodes);
+	rp->values = g_slist_delete_link(rp->values, rp->values);
+}
+
+static void
+replay_text(GMarkupParseContext *context, const char *text, gsize len,
+    gpointer user_data, GError **error)
+{
+	struct replay_parser *rp;
+	gsize i;
+
+	rp = user_data;
+	if (rp->skip || rp->nodes == NULL)
+		return;
+	if (rp->values->data == NULL) {
+		/* ignore the indentation between the elements */
+		for (i = 0; i < len && g_ascii_isspace(text[i]); ++i);
+		if (i == len)
+			return;
+		rp->values->data = g_string_sized_new(len);
+	}
+	g_string_append_len(rp->values->data, text, len);
+}
+
+static const GMarkupParser replay_parser_funcs = {
+	replay_start_element,
+	replay_end_element,
+	replay_text,
+	NULL,
+	NULL
+};
+
+static LmMessage *
+replay_parse(const char *xml, gsize len)
+{
+	GMarkupParseContext *context;
+	struct replay_parser rp;
+	GSList *tmp;
+
+	memset(&rp, 0, sizeof(rp));
+	context = g_markup_parse_context_new(&replay_parser_funcs, 0, &rp,
+	    NULL);
+	if (!g_markup_parse_context_parse(context, xml, len, NULL)
+	    || !g_markup_parse_context_end_parse(context, NULL)) {
+		if (rp.lmsg != NULL)
+			lm_message_unref(rp.lmsg);
+		rp.lmsg = NULL;
+	}
+	g_markup_parse_context_free(context);
+	for (tmp = rp.values; tmp != NULL; tmp = tmp->next)
+		if (tmp->data != NULL)
+			g_string_free(tmp->data, TRUE);
+	g_slist_free(rp.values);
+	g_slist_free(rp.nodes);
+	return rp.lmsg;
+}
+
+/* SYNTAX: XMPPCAPTURE <file>
+ *         XMPPCAPTURE -stop */
+static void
+cmd_xmppcapture(const char *data, XMPP_SERVER_REC *server)
+{
+	GHashTable *optlist;
+	char *path, *fname;
+	void *free_arg;
+
+	if (!cmd_get_params(data, &free_arg, 1 | PARAM_FLAG_OPTIONS,
+	    "xmppcapture", &optlist, &path))
+		return;
+	if (capture_file != NULL) {
+		fclose(capture_file);
+		capture_file = NULL;
+	}
+	if (g_hash_table_lookup(optlist, "stop") != NULL) {
+		cmd_params_free(free_arg);
+		return;
+	}
+	if (*path == '\0')
+		cmd_param_error(CMDERR_NOT_ENOUGH_PARAMS);
+	fname = convert_home(path);
+	capture_file = fopen(fname, "wb");
+	g_free(fname);
+	if (capture_file == NULL)
+		cmd_param_error(CMDERR_ERRNO);
+	if (fwrite(CAPTURE_MAGIC, CAPTURE_MAGIC_LEN, 1, capture_file) != 1) {
+		fclose(capture_file);
+		capture_file = NULL;
+		cmd_param_error(CMDERR_ERRNO);
+	}
+	capture_start = g_get_monotonic_time();
+	cmd_params_free(free_arg);
+}
+
+/* SYNTAX: XMPPREPLAY <file> */
+static void
+cmd_xmppreplay(const char *data, XMPP_SERVER_REC *server)
+{
+	LmMessage *lmsg;
+	const unsigned char *p, *end;
+	char *path, *fname, *contents, *msg;
+	gsize length;
+	guint32 len;
+	gint64 start;
+	int count, errors;
+	void *free_arg;
+
+	CMD_XMPP_SERVER(server);
+	if (!cmd_get_params(data, &free_arg, 1, &path))
+		return;
+	if (*path == '\0')
+		cmd_param_error(CMDERR_NOT_ENOUGH_PARAMS);
+	fname = convert_home(path);
+	if (!g_file_get_contents(fname, &contents, &length, NULL)) {
+		g_free(fname);
+		cmd_param_error(CMDERR_ERRNO);
+	}
+	g_free(fname);
+	if (length < CAPTURE_MAGIC_LEN
+	    || memcmp(contents, CAPTURE_MAGIC, CAPTURE_MAGIC_LEN) != 0) {
+		g_free(contents);
+		signal_emit("xmpp server status", 2, server,
+		    "Not a stanza capture file.");
+		cmd_params_free(free_arg);
+		return;
+	}
+	/* the stanzas are decoded and checked like the received ones, but
+	 * never reach the handlers: the live session is left untouched */
+	server->replaying = TRUE;
+	count = errors = 0;
+	start = g_get_monotonic_time();
+	p = (unsigned char *)contents + CAPTURE_MAGIC_LEN;
+	end = (unsigned char *)contents + length;
+	while (end - p >= CAPTURE_HEADER_LEN) {
+		len = get_uint32(p);
+		if ((gsize)(end - p - CAPTURE_HEADER_LEN) < len)
+			break;
+		if (p[4] == '<') {
+			lmsg = replay_parse((char *)p + CAPTURE_HEADER_LEN, len);
+			if (lmsg != NULL) {
+				stanzas_replay(server, lmsg);
+				lm_message_unref(lmsg);
+				count++;
+			} else
+				errors++;
+		}
+		p += CAPTURE_HEADER_LEN + len;
+	}
+	server->replaying = FALSE;
+	msg = g_strdup_printf("Replayed %d stanzas in %ld ms (%d invalid)",
+	    count, (long)((g_get_monotonic_time() - start) / 1000), errors);
+	signal_emit("xmpp server status", 2, server, msg);
+	g_free(msg);
+	g_free(contents);
+	cmd_params_free(free_arg);
+}
+
+void
+capture_init(void)
+{
+	command_bind("xmppcapture", NULL, (SIGNAL_FUNC)cmd_xmppcapture);
+	command_set_options("xmppcapture", "stop");
+	command_bind_xmpp("xmppreplay", NULL, (SIGNAL_FUNC)cmd_xmppreplay);
+}
+
+void
+capture_deinit(void)
+{
+	command_unbind("xmppcapture", (SIGNAL_FUNC)cmd_xmppcapture);
+	command_unbind("xmppreplay", (SIGNAL_FUNC)cmd_xmppreplay);
+	if (capture_file != NULL) {
+		fclose(capture_file);
+		capture_file = NULL;
+	}
+}
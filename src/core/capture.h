@@ -0,0 +1,11 @@
+#ifndef __CAPTURE_H
+#define __CAPTURE_H
+
+__BEGIN_DECLS
+void	capture_stanza(XMPP_SERVER_REC *, const char *, int);
+
+void	capture_init(void);
+void	capture_deinit(void);
+__END_DECLS
+
+#endif
@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Pending IQ requests: the replies are routed to the callback of the
+ * request by id, before any module sees them
+ */
+
+#include <string.h>
+
+#include "module.h"
+#include "settings.h"
+#include "signals.h"
+
+#include "xmpp-servers.h"
+#include "iq.h"
+#include "jids.h"
+#include "keywords.h"
+#include "tools.h"
+
+#define IQ_ID_PREFIX		"irssi-xmpp-iq-"
+#define IQ_ID_PREFIX_LEN	(sizeof(IQ_ID_PREFIX) - 1)
+
+struct iq_request {
+	char		*id;
+	char		*to;
+	gboolean	 own;	/* to our server or our account */
+	gint64		 deadline;
+	XMPP_IQ_FUNC	 func;
+	gpointer	 user_data;
+	GDestroyNotify	 destroy;
+};
+
+static guint	 last_id;
+static int	 timeout_tag;
+static gint64	 next_deadline;
+static int	 default_timeout;
+
+static void
+free_request(struct iq_request *req)
+{
+	if (req->destroy != NULL)
+		req->destroy(req->user_data);
+	g_free(req->id);
+	g_free(req->to);
+	g_free(req);
+}
+
+static void
+fail_request(XMPP_SERVER_REC *server, struct iq_request *req)
+{
+	req->func(server, NULL, LM_MESSAGE_SUB_TYPE_ERROR,
+	    req->to != NULL ? req->to : "", req->user_data);
+	free_request(req);
+}
+
+static gboolean expire_func(void);
+
+static void
+schedule_expire(gint64 deadline)
+{
+	gint64 now;
+
+	if (timeout_tag != 0) {
+		if (deadline >= next_deadline)
+			return;
+		g_source_remove(timeout_tag);
+	}
+	now = g_get_monotonic_time();
+	next_deadline = deadline;
+	timeout_tag = g_timeout_add(deadline > now ?
+	    (deadline - now) / 1000 + 1 : 0, (GSourceFunc)expire_func, NULL);
+}
+
+/* one timer for all the requests, set to the closest deadline */
+static gboolean
+expire_func(void)
+{
+	GSList *tmp, *expired, *servers_expired;
+	GHashTableIter iter;
+	XMPP_SERVER_REC *server;
+	struct iq_request *req;
+	gint64 now, next;
+
+	timeout_tag = 0;
+	now = g_get_monotonic_time();
+	next = G_MAXINT64;
+	expired = servers_expired = NULL;
+	for (tmp = servers; tmp != NULL; tmp = tmp->next) {
+		if ((server = XMPP_SERVER(tmp->data)) == NULL
+		    || server->iq_requests == NULL)
+			continue;
+		g_hash_table_iter_init(&iter, server->iq_requests);
+		while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&req)) {
+			if (req->deadline > now) {
+				next = MIN(next, req->deadline);
+				continue;
+			}
+			g_hash_table_iter_steal(&iter);
+			expired = g_slist_prepend(expired, req);
+			servers_expired = g_slist_prepend(servers_expired,
+			    server);
+		}
+	}
+	if (next != G_MAXINT64)
+		schedule_expire(next);
+	/* the callbacks may send new requests */
+	while (expired != NULL) {
+		fail_request(servers_expired->data, expired->data);
+		expired = g_slist_delete_link(expired, expired);
+		servers_expired = g_slist_delete_link(servers_expired,
+		    servers_expired);
+	}
+	return FALSE;
+}
+
+/* Sends the IQ request and calls func with its reply, or with a NULL
+ * message if there is none after timeout msecs (or the default timeout
+ * if timeout is 0) */
+void
+xmpp_iq_send(XMPP_SERVER_REC *server, LmMessage *lmsg, int timeout,
+    XMPP_IQ_FUNC func, gpointer user_data, GDestroyNotify destroy)
+{
+	struct iq_request *req;
+	char *bare;
+
+	g_return_if_fail(IS_XMPP_SERVER(server));
+	g_return_if_fail(lmsg != NULL);
+	g_return_if_fail(func != NULL);
+	req = g_new0(struct iq_request, 1);
+	req->id = g_strdup_printf(IQ_ID_PREFIX "%u", ++last_id);
+	req->to = xmpp_recode_in(
+	    lm_message_node_get_attribute(lmsg->node, "to"));
+	if (req->to == NULL || xmpp_jid_equal(req->to, server->domain))
+		req->own = TRUE;
+	else {
+		/* the destination is often our full JID */
+		bare = xmpp_strip_resource(req->to);
+		req->own = xmpp_jid_equal(bare, server->jid);
+		g_free(bare);
+	}
+	if (timeout <= 0)
+		timeout = default_timeout;
+	req->deadline = g_get_monotonic_time() + (gint64)timeout * 1000;
+	req->func = func;
+	req->user_data = user_data;
+	req->destroy = destroy;
+	lm_message_node_set_attribute(lmsg->node, "id", req->id);
+	if (server->iq_requests == NULL)
+		server->iq_requests = g_hash_table_new(g_str_hash,
+		    g_str_equal);
+	g_hash_table_insert(server->iq_requests, req->id, req);
+	schedule_expire(req->deadline);
+	signal_emit("xmpp send iq", 2, server, lmsg);
+}
+
+/* Forgets the request without calling its callback */
+gboolean
+xmpp_iq_cancel(XMPP_SERVER_REC *server, const char *id)
+{
+	struct iq_request *req;
+
+	g_return_val_if_fail(IS_XMPP_SERVER(server), FALSE);
+	g_return_val_if_fail(id != NULL, FALSE);
+	if (server->iq_requests == NULL
+	    || (req = g_hash_table_lookup(server->iq_requests, id)) == NULL)
+		return FALSE;
+	g_hash_table_remove(server->iq_requests, id);
+	free_request(req);
+	return TRUE;
+}
+
+/* Tells the user that a request got an error, or no reply if lmsg is NULL */
+void
+xmpp_iq_report(XMPP_SERVER_REC *server, LmMessage *lmsg, const char *from,
+    const char *request)
+{
+	LmMessageNode *node;
+	const char *condition;
+	char *msg;
+
+	g_return_if_fail(IS_XMPP_SERVER(server));
+	g_return_if_fail(request != NULL);
+	/* the pending requests fail when the server disconnects */
+	if (server->disconnected)
+		return;
+	if (from == NULL || *from == '\0')
+		from = server->domain;
+	if (lmsg == NULL)
+		msg = g_strdup_printf("No reply from %s to the %s request.",
+		    from, request);
+	else {
+		condition = (node = lm_message_node_get_child(lmsg->node,
+		    "error")) != NULL ? xmpp_get_error_condition(node) : NULL;
+		msg = g_strdup_printf("The %s request to %s failed: %s.",
+		    request, from, condition != NULL ? condition : "error");
+	}
+	signal_emit("xmpp server status", 2, server, msg);
+	g_free(msg);
+}
+
+int
+xmpp_iq_pending_count(XMPP_SERVER_REC *server)
+{
+	g_return_val_if_fail(IS_XMPP_SERVER(server), 0);
+	return server->iq_requests == NULL ? 0
+	    : g_hash_table_size(server->iq_requests);
+}
+
+static gboolean
+check_sender(XMPP_SERVER_REC *server, struct iq_request *req,
+    const char *from)
+{
+	/* our server answers for itself and for our account with or
+	 * without the from attribute */
+	if (req->own && (*from == '\0'
+	    || xmpp_jid_equal(from, server->domain)
+	    || xmpp_jid_equal(from, server->jid)))
+		return TRUE;
+	return *from != '\0' && req->to != NULL
+	    && xmpp_jid_equal(from, req->to);
+}
+
+static void
+sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
+    const char *id, const char *from, const char *to)
+{
+	struct iq_request *req;
+
+	if ((type != LM_MESSAGE_SUB_TYPE_RESULT
+	    && type != LM_MESSAGE_SUB_TYPE_ERROR)
+	    || strncmp(id, IQ_ID_PREFIX, IQ_ID_PREFIX_LEN) != 0)
+		return;
+	/* replies to our requests never reach the other modules: late
+	 * and spoofed ones are dropped here */
+	signal_stop();
+	if (server->iq_requests == NULL
+	    || (req = g_hash_table_lookup(server->iq_requests, id)) == NULL
+	    || !check_sender(server, req, from))
+		return;
+	g_hash_table_remove(server->iq_requests, id);
+	req->func(server, lmsg, type, from, req->user_data);
+	free_request(req);
+}
+
+static void
+sig_disconnected(XMPP_SERVER_REC *server)
+{
+	GHashTable *requests;
+	GHashTableIter iter;
+	struct iq_request *req;
+
+	if (!IS_XMPP_SERVER(server) || server->iq_requests == NULL)
+		return;
+	requests = server->iq_requests;
+	server->iq_requests = NULL;
+	g_hash_table_iter_init(&iter, requests);
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&req))
+		fail_request(server, req);
+	g_hash_table_destroy(requests);
+}
+
+static void
+read_settings(void)
+{
+	default_timeout = settings_get_time("xmpp_iq_timeout");
+	if (default_timeout <= 0)
+		default_timeout = 60 * 1000;
+}
+
+void
+iq_init(void)
+{
+	last_id = 0;
+	timeout_tag = 0;
+	settings_add_time("xmpp", "xmpp_iq_timeout", "1min");
+	read_settings();
+	signal_add_first("xmpp recv iq", sig_recv_iq);
+	signal_add("server disconnected", sig_disconnected);
+	signal_add("setup changed", read_settings);
+}
+
+void
+iq_deinit(void)
+{
+	if (timeout_tag != 0)
+		g_source_remove(timeout_tag);
+	signal_remove("xmpp recv iq", sig_recv_iq);
+	signal_remove("server disconnected", sig_disconnected);
+	signal_remove("setup changed", read_settings);
+}
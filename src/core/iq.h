@@ -0,0 +1,20 @@
+#ifndef __IQ_H
+#define __IQ_H
+
+/* lmsg is NULL when the request timed out or the server disconnected */
+typedef void (*XMPP_IQ_FUNC)(XMPP_SERVER_REC *, LmMessage *, int,
+    const char *, gpointer);
+
+__BEGIN_DECLS
+void	 xmpp_iq_send(XMPP_SERVER_REC *, LmMessage *, int, XMPP_IQ_FUNC,
+	     gpointer, GDestroyNotify);
+gboolean xmpp_iq_cancel(XMPP_SERVER_REC *, const char *);
+void	 xmpp_iq_report(XMPP_SERVER_REC *, LmMessage *, const char *,
+	     const char *);
+int	 xmpp_iq_pending_count(XMPP_SERVER_REC *);
+
+void	iq_init(void);
+void	iq_deinit(void);
+__END_DECLS
+
+#endif
@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * JID atoms: every distinct JID held by the roster, the nicklists or the
+ * datalists is stored once. The atoms are plain strings, preceded by their
+ * hash, their reference count and the length of their bare part, so two
+ * atoms are equal if and only if their pointers are.
+ *
+ * Atoms are keyed by the canonical form of the JID: the bare part is case
+ * folded and normalized (NFKC), the resource is kept as is. An atom keeps
+ * the spelling it was created with, for display, and differently spelled
+ * JIDs with the same canonical form share it. The canonical form of each
+ * distinct raw JID is computed once and kept in a cache.
+ */
+
+#include <string.h>
+
+#include "module.h"
+
+#include "jids.h"
+
+struct jid_atom {
+	guint	 hash;
+	guint	 refcount;
+	gsize	 bare_len;
+	char	*canonical;	/* str itself when it is canonical */
+	char	 str[1];
+};
+
+#define JID_ATOM(jid)	((struct jid_atom *)((char *)(jid)		\
+			    - G_STRUCT_OFFSET(struct jid_atom, str)))
+
+struct jid_canon {
+	char	*canonical;
+	char	 raw[1];
+};
+
+/* bare JIDs longer than this are looked up from a copy on the heap */
+#define JID_BUF_LEN	256
+
+/* the cache of canonical forms is emptied when it reaches this size */
+#define JID_CANON_MAX	4096
+
+static GHashTable *atoms;
+static GHashTable *canons;
+
+/*
+ * Approximation of nodeprep and nameprep without libidn: compatibility
+ * normalization and case folding. Returns NULL if it isn't valid UTF-8.
+ */
+static char *
+prep_bare(const char *bare, gssize len)
+{
+	char *str, *folded;
+
+	if ((str = g_utf8_normalize(bare, len, G_NORMALIZE_NFKC)) == NULL)
+		return NULL;
+	folded = g_utf8_casefold(str, -1);
+	g_free(str);
+	str = g_utf8_normalize(folded, -1, G_NORMALIZE_NFKC);
+	g_free(folded);
+	return str;
+}
+
+/*
+ * Returns the canonical form of the JID, it is either the JID itself or a
+ * string owned by the cache, valid until the next call.
+ */
+const char *
+xmpp_jid_canonical(const char *jid)
+{
+	struct jid_canon *canon;
+	const char *pos;
+	char *bare;
+	gsize bare_len, len, res_len, prep_len;
+	gboolean ascii, upper;
+
+	g_return_val_if_fail(jid != NULL, NULL);
+	ascii = TRUE;
+	upper = FALSE;
+	for (pos = jid; *pos != '\0' && *pos != '/'; pos++) {
+		if ((guchar)*pos >= 0x80)
+			ascii = FALSE;
+		else if (g_ascii_isupper(*pos))
+			upper = TRUE;
+	}
+	bare_len = pos - jid;
+	/* lower case ASCII without the final dot of a FQDN */
+	if (ascii && !upper && (bare_len == 0 || jid[bare_len-1] != '.'))
+		return jid;
+	if ((canon = g_hash_table_lookup(canons, jid)) != NULL)
+		return canon->canonical;
+	len = bare_len;
+	if (len > 0 && jid[len-1] == '.')
+		len--;
+	if (ascii)
+		bare = g_ascii_strdown(jid, len);
+	else if ((bare = prep_bare(jid, len)) == NULL)
+		return jid;
+	prep_len = strlen(bare);
+	res_len = strlen(jid + bare_len);
+	if (g_hash_table_size(canons) >= JID_CANON_MAX)
+		g_hash_table_remove_all(canons);
+	canon = g_malloc(G_STRUCT_OFFSET(struct jid_canon, raw)
+	    + bare_len + res_len + 1 + prep_len + res_len + 1);
+	memcpy(canon->raw, jid, bare_len + res_len + 1);
+	canon->canonical = canon->raw + bare_len + res_len + 1;
+	memcpy(canon->canonical, bare, prep_len);
+	memcpy(canon->canonical + prep_len, jid + bare_len, res_len + 1);
+	g_free(bare);
+	g_hash_table_insert(canons, canon->raw, canon);
+	return canon->canonical;
+}
+
+gboolean
+xmpp_jid_equal(const char *jid1, const char *jid2)
+{
+	char *canonical;
+	gboolean equal;
+
+	g_return_val_if_fail(jid1 != NULL, FALSE);
+	g_return_val_if_fail(jid2 != NULL, FALSE);
+	if (strcmp(jid1, jid2) == 0)
+		return TRUE;
+	canonical = g_strdup(xmpp_jid_canonical(jid1));
+	equal = strcmp(canonical, xmpp_jid_canonical(jid2)) == 0;
+	g_free(canonical);
+	return equal;
+}
+
+char *
+xmpp_jid_lookup(const char *jid)
+{
+	g_return_val_if_fail(jid != NULL, NULL);
+	return g_hash_table_lookup(atoms, xmpp_jid_canonical(jid));
+}
+
+char *
+xmpp_jid_lookup_len(const char *jid, gsize len)
+{
+	char buf[JID_BUF_LEN], *str, *atom;
+
+	g_return_val_if_fail(jid != NULL, NULL);
+	if (jid[len] == '\0')
+		return xmpp_jid_lookup(jid);
+	str = len < sizeof(buf) ? buf : g_malloc(len + 1);
+	memcpy(str, jid, len);
+	str[len] = '\0';
+	atom = xmpp_jid_lookup(str);
+	if (str != buf)
+		g_free(str);
+	return atom;
+}
+
+char *
+xmpp_jid_ref(const char *jid)
+{
+	struct jid_atom *atom;
+	const char *canonical, *pos;
+	char *str;
+	gsize len, canonical_len;
+
+	g_return_val_if_fail(jid != NULL, NULL);
+	canonical = xmpp_jid_canonical(jid);
+	if ((str = g_hash_table_lookup(atoms, canonical)) != NULL) {
+		JID_ATOM(str)->refcount++;
+		return str;
+	}
+	len = strlen(jid);
+	canonical_len = canonical != jid ? strlen(canonical) + 1 : 0;
+	atom = g_malloc(G_STRUCT_OFFSET(struct jid_atom, str) + len + 1
+	    + canonical_len);
+	memcpy(atom->str, jid, len + 1);
+	if (canonical != jid) {
+		atom->canonical = atom->str + len + 1;
+		memcpy(atom->canonical, canonical, canonical_len);
+	} else
+		atom->canonical = atom->str;
+	atom->hash = g_str_hash(atom->canonical);
+	atom->refcount = 1;
+	pos = strchr(atom->str, '/');
+	atom->bare_len = pos != NULL ? (gsize)(pos - atom->str) : len;
+	g_hash_table_insert(atoms, atom->canonical, atom->str);
+	return atom->str;
+}
+
+void
+xmpp_jid_unref(char *jid)
+{
+	struct jid_atom *atom;
+
+	if (jid == NULL)
+		return;
+	atom = JID_ATOM(jid);
+	g_return_if_fail(atom->refcount > 0);
+	if (--atom->refcount > 0)
+		return;
+	g_hash_table_remove(atoms, atom->canonical);
+	g_free(atom);
+}
+
+guint
+xmpp_jid_hash(gconstpointer jid)
+{
+	return JID_ATOM(jid)->hash;
+}
+
+gsize
+xmpp_jid_bare_len(const char *jid)
+{
+	return JID_ATOM(jid)->bare_len;
+}
+
+void
+jids_init(void)
+{
+	atoms = g_hash_table_new(g_str_hash, g_str_equal);
+	canons = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, g_free);
+}
+
+void
+jids_deinit(void)
+{
+	/* the remaining atoms are still referenced by other modules */
+	g_hash_table_destroy(atoms);
+	atoms = NULL;
+	g_hash_table_destroy(canons);
+	canons = NULL;
+}
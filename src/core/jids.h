@@ -0,0 +1,19 @@
+#ifndef __JIDS_H
+#define __JIDS_H
+
+__BEGIN_DECLS
+const char	*xmpp_jid_canonical(const char *);
+gboolean	 xmpp_jid_equal(const char *, const char *);
+
+char	*xmpp_jid_ref(const char *);
+void	 xmpp_jid_unref(char *);
+char	*xmpp_jid_lookup(const char *);
+char	*xmpp_jid_lookup_len(const char *, gsize);
+guint	 xmpp_jid_hash(gconstpointer);
+gsize	 xmpp_jid_bare_len(const char *);
+
+void	jids_init(void);
+void	jids_deinit(void);
+__END_DECLS
+
+#endif
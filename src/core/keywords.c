@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Keyword tables of the protocol's enumerated values: each table is a
+ * perfect hash, so decoding a value costs one hash and one comparison.
+ *
+ * The slot of a keyword is keyword_hash() of the keyword with the seed of
+ * its table, masked with the size of the table minus one. The seeds were
+ * chosen so that no two keywords of a table share a slot: when a keyword is
+ * added, a new seed may be needed.
+ */
+
+#include <stdlib.h>
+
+#include "module.h"
+
+#include "keywords.h"
+#include "rosters.h"
+#include "xep/muc-affiliation.h"
+#include "xep/muc-role.h"
+
+struct keyword {
+	const char	*name;
+	int		 value;
+};
+
+struct keyword_table {
+	const struct keyword	*slots;
+	guint32			 seed;
+	guint32			 mask;
+};
+
+static const struct keyword show_slots[8] = {
+	{ "chat",	XMPP_PRESENCE_CHAT },
+	{ NULL,		0 },
+	{ "online",	XMPP_PRESENCE_AVAILABLE },
+	{ "xa",		XMPP_PRESENCE_XA },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ "dnd",	XMPP_PRESENCE_DND },
+	{ "away",	XMPP_PRESENCE_AWAY }
+};
+
+static const struct keyword subscription_slots[8] = {
+	{ "none",	XMPP_SUBSCRIPTION_NONE },
+	{ "to",		XMPP_SUBSCRIPTION_TO },
+	{ "both",	XMPP_SUBSCRIPTION_BOTH },
+	{ "from",	XMPP_SUBSCRIPTION_FROM },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ "remove",	XMPP_SUBSCRIPTION_REMOVE }
+};
+
+static const struct keyword affiliation_slots[8] = {
+	{ "none",	XMPP_AFFILIATION_NONE },
+	{ "admin",	XMPP_AFFILIATION_ADMIN },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ "owner",	XMPP_AFFILIATION_OWNER },
+	{ "outcast",	XMPP_AFFILIATION_OUTCAST },
+	{ "member",	XMPP_AFFILIATION_MEMBER },
+	{ NULL,		0 }
+};
+
+static const struct keyword role_slots[8] = {
+	{ "none",	XMPP_ROLE_NONE },
+	{ "participant", XMPP_ROLE_PARTICIPANT },
+	{ "moderator",	XMPP_ROLE_MODERATOR },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ "visitor",	XMPP_ROLE_VISITOR },
+	{ NULL,		0 }
+};
+
+static const struct keyword type_slots[32] = {
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ "result",	LM_MESSAGE_SUB_TYPE_RESULT },
+	{ NULL,		0 },
+	{ "chat",	LM_MESSAGE_SUB_TYPE_CHAT },
+	{ "probe",	LM_MESSAGE_SUB_TYPE_PROBE },
+	{ NULL,		0 },
+	{ "unavailable", LM_MESSAGE_SUB_TYPE_UNAVAILABLE },
+	{ NULL,		0 },
+	{ "subscribed",	LM_MESSAGE_SUB_TYPE_SUBSCRIBED },
+	{ "headline",	LM_MESSAGE_SUB_TYPE_HEADLINE },
+	{ "available",	LM_MESSAGE_SUB_TYPE_AVAILABLE },
+	{ "groupchat",	LM_MESSAGE_SUB_TYPE_GROUPCHAT },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ "get",	LM_MESSAGE_SUB_TYPE_GET },
+	{ "normal",	LM_MESSAGE_SUB_TYPE_NORMAL },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ "subscribe",	LM_MESSAGE_SUB_TYPE_SUBSCRIBE },
+	{ "set",	LM_MESSAGE_SUB_TYPE_SET },
+	{ "unsubscribed", LM_MESSAGE_SUB_TYPE_UNSUBSCRIBED },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ NULL,		0 },
+	{ "error",	LM_MESSAGE_SUB_TYPE_ERROR },
+	{ NULL,		0 },
+	{ "unsubscribe", LM_MESSAGE_SUB_TYPE_UNSUBSCRIBE }
+};
+
+/* RFC 6120 conditions and their legacy codes (XEP-0086) */
+static const struct keyword error_slots[64] = {
+	{ NULL,				0 },
+	{ "gone",			302 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ "remote-server-timeout",	504 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ "not-allowed",		405 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ "resource-constraint",	500 },
+	{ "subscription-required",	407 },
+	{ NULL,				0 },
+	{ "bad-request",		400 },
+	{ "remote-server-not-found",	404 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ "not-acceptable",		406 },
+	{ "unexpected-request",		400 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ "service-unavailable",	503 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ "conflict",			409 },
+	{ "feature-not-implemented",	501 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ "forbidden",			403 },
+	{ "recipient-unavailable",	404 },
+	{ "redirect",			302 },
+	{ NULL,				0 },
+	{ "internal-server-error",	500 },
+	{ "undefined-condition",	500 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ "registration-required",	407 },
+	{ "not-authorized",		401 },
+	{ "jid-malformed",		400 },
+	{ "payment-required",		402 },
+	{ "item-not-found",		404 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 },
+	{ NULL,				0 }
+};
+
+#define TABLE(slots, seed) \
+	{ (slots), (seed), G_N_ELEMENTS(slots) - 1 }
+
+static const struct keyword_table keyword_tables[XMPP_KEYWORDS_LEN] = {
+	TABLE(show_slots, 2),
+	TABLE(subscription_slots, 5),
+	TABLE(affiliation_slots, 4),
+	TABLE(role_slots, 5),
+	TABLE(type_slots, 77),
+	TABLE(error_slots, 44)
+};
+
+/* case insensitive for ASCII, as are the comparisons */
+static guint32
+keyword_hash(const char *str, guint32 seed)
+{
+	guint32 h;
+
+	for (h = seed; *str != '\0'; ++str)
+		h = h * 33 + ((guchar)*str | 0x20);
+	return h ^ (h >> 13);
+}
+
+int
+xmpp_keyword(int table, const char *str, int def)
+{
+	const struct keyword_table *kt;
+	const struct keyword *kw;
+
+	g_return_val_if_fail(table >= 0 && table < XMPP_KEYWORDS_LEN, def);
+	if (str == NULL)
+		return def;
+	kt = &keyword_tables[table];
+	kw = &kt->slots[keyword_hash(str, kt->seed) & kt->mask];
+	return kw->name != NULL && g_ascii_strcasecmp(kw->name, str) == 0 ?
+	    kw->value : def;
+}
+
+/*
+ * Returns the legacy code of an error element, from its code attribute or
+ * from its defined condition, 0 if it has neither.
+ */
+int
+xmpp_get_error_code(LmMessageNode *error)
+{
+	LmMessageNode *node;
+	const char *code;
+	int value;
+
+	g_return_val_if_fail(error != NULL, 0);
+	if ((code = lm_message_node_get_attribute(error, "code")) != NULL)
+		return atoi(code);
+	for (node = error->children; node != NULL; node = node->next)
+		if ((value = xmpp_keyword(XMPP_KEYWORDS_ERROR, node->name,
+		    0)) != 0)
+			return value;
+	return 0;
+}
+
+/*
+ * Returns the defined condition of an error element, NULL if it has none
+ * (legacy errors only have a code).
+ */
+const char *
+xmpp_get_error_condition(LmMessageNode *error)
+{
+	LmMessageNode *node;
+
+	g_return_val_if_fail(error != NULL, NULL);
+	for (node = error->children; node != NULL; node = node->next)
+		if (xmpp_keyword(XMPP_KEYWORDS_ERROR, node->name, 0) != 0)
+			return node->name;
+	return NULL;
+}
@@ -0,0 +1,22 @@
+#ifndef __KEYWORDS_H
+#define __KEYWORDS_H
+
+#include "loudmouth/loudmouth.h"
+
+enum {
+	XMPP_KEYWORDS_SHOW,
+	XMPP_KEYWORDS_SUBSCRIPTION,
+	XMPP_KEYWORDS_AFFILIATION,
+	XMPP_KEYWORDS_ROLE,
+	XMPP_KEYWORDS_TYPE,
+	XMPP_KEYWORDS_ERROR,
+	XMPP_KEYWORDS_LEN
+};
+
+__BEGIN_DECLS
+int	xmpp_keyword(int, const char *, int);
+int	xmpp_get_error_code(LmMessageNode *);
+const char *xmpp_get_error_condition(LmMessageNode *);
+__END_DECLS
+
+#endif
@@ -31,10 +31,48 @@ lm_find_node(LmMessageNode *node, const char *name,
 	if (node == NULL)
 		return NULL;
 	for (l = node->children; l != NULL; l = l->next)
-		if (strcmp(l->name, name) == 0) {
+		/* the first byte rejects most of the children without a call */
+		if (*l->name == *name && strcmp(l->name, name) == 0) {
 			v = lm_message_node_get_attribute(l, attribute);
 			if (v != NULL && strcmp(value, v) == 0)
 				return l;
 		}
 	return NULL;
 }
+
+/*
+ * Looks for several children in a single traversal. Each request is
+ * matched by the first child with its name and, if the attribute isn't
+ * NULL, with the attribute set to the value. Returns the number of
+ * requests matched, their node is NULL if they weren't.
+ */
+int
+lm_find_nodes(LmMessageNode *node, LM_FIND_REC *finds, int count)
+{
+	LmMessageNode *l;
+	const char *v;
+	int i, found;
+
+	g_return_val_if_fail(finds != NULL, 0);
+	for (i = 0; i < count; ++i)
+		finds[i].node = NULL;
+	if (node == NULL)
+		return 0;
+	found = 0;
+	for (l = node->children; l != NULL && found < count; l = l->next)
+		for (i = 0; i < count; ++i) {
+			if (finds[i].node != NULL || *l->name != *finds[i].name
+			    || strcmp(l->name, finds[i].name) != 0)
+				continue;
+			if (finds[i].attribute != NULL) {
+				v = lm_message_node_get_attribute(l,
+				    finds[i].attribute);
+				if (v == NULL || strcmp(v, finds[i].value) != 0)
+					continue;
+			}
+			finds[i].node = l;
+			found++;
+			break;
+		}
+	return found;
+}
@@ -1,9 +1,17 @@
 #ifndef __LOUDMOUTH_TOOLS_H
 #define __LOUDMOUTH_TOOLS_H
 
+typedef struct {
+	const char	*name;
+	const char	*attribute;
+	const char	*value;
+	LmMessageNode	*node;
+} LM_FIND_REC;
+
 __BEGIN_DECLS
 LmMessageNode	*lm_find_node(LmMessageNode *, const char *,
 		     const char *, const char *);
+int		 lm_find_nodes(LmMessageNode *, LM_FIND_REC *, int);
 __END_DECLS
 
 #endif
@@ -21,17 +21,11 @@
 #include "module.h"
 
 #include "xmpp-servers.h"
+#include "jids.h"
+#include "keywords.h"
 #include "rosters-tools.h"
 #include "tools.h"
 
-static int
-find_user_func(gconstpointer user, gconstpointer jid)
-{
-	g_return_val_if_fail(user != NULL, -1);
-	g_return_val_if_fail(jid != NULL, -1);
-	return strcmp(((XMPP_ROSTER_USER_REC *)user)->jid, jid);
-}
-
 static int
 find_username_func(gconstpointer user_pointer, gconstpointer name)
 {
@@ -77,31 +71,32 @@ XMPP_ROSTER_USER_REC *
 rosters_find_user(GSList *groups, const char *jid,
     XMPP_ROSTER_GROUP_REC **group, XMPP_ROSTER_RESOURCE_REC **resource)
 {
-	GSList *group_tmp, *gl, *ul;
-	char *pos;
-
-	if ((pos = xmpp_find_resource_sep(jid)) != NULL)
-		*pos = '\0';
-	group_tmp = ul = NULL;
-	for (gl = groups; ul == NULL && gl != NULL;
-	    gl = gl->next) {
-		ul = g_slist_find_custom(
-		    ((XMPP_ROSTER_GROUP_REC *)gl->data)->users, jid,
-		    find_user_func);
-		group_tmp = gl;
+	GSList *gl, *ul;
+	XMPP_ROSTER_USER_REC *user;
+	char *pos, *atom;
+
+	pos = xmpp_find_resource_sep(jid);
+	/* the JIDs of the roster are atoms: without an atom there is no
+	 * such user, otherwise comparing the pointers is enough */
+	atom = pos != NULL ?
+	    xmpp_jid_lookup_len(jid, pos - jid) : xmpp_jid_lookup(jid);
+	user = NULL;
+	for (gl = groups; atom != NULL && gl != NULL; gl = gl->next) {
+		for (ul = ((XMPP_ROSTER_GROUP_REC *)gl->data)->users;
+		    ul != NULL; ul = ul->next)
+			if (((XMPP_ROSTER_USER_REC *)ul->data)->jid == atom) {
+				user = ul->data;
+				break;
+			}
+		if (user != NULL)
+			break;
 	}
 	if (group != NULL)
-		*group = ul != NULL ?
-		    (XMPP_ROSTER_GROUP_REC *)group_tmp->data : NULL;
+		*group = user != NULL ? gl->data : NULL;
 	if (resource != NULL)
-		*resource = ul != NULL && pos != NULL ?
-		    rosters_find_resource(
-		    ((XMPP_ROSTER_USER_REC *)ul->data)->resources, pos+1)
-		    : NULL;
-	if (pos != NULL)
-		*pos = '/';
-	return ul != NULL ?
-	    (XMPP_ROSTER_USER_REC *)ul->data : NULL;
+		*resource = user != NULL && pos != NULL ?
+		    rosters_find_resource(user->resources, pos+1) : NULL;
+	return user;
 }
 
 XMPP_ROSTER_USER_REC *
@@ -183,48 +178,38 @@ rosters_resolve_name(XMPP_SERVER_REC *server, const char *name)
 char *
 rosters_get_name(XMPP_SERVER_REC *server, const char *full_jid)
 {
-	GSList *gl, *ul;
-	XMPP_ROSTER_GROUP_REC *group;
 	XMPP_ROSTER_USER_REC *user;
-	char *jid;
 
 	g_return_val_if_fail(IS_XMPP_SERVER(server), NULL);
 	g_return_val_if_fail(full_jid != NULL, NULL);
-	if ((jid = xmpp_strip_resource(full_jid)) == NULL)
-		return NULL;
-	for (gl = server->roster; gl != NULL; gl = gl->next) {
-		group = gl->data;
-		for (ul = group->users; ul != NULL; ul = ul->next) {
-			user = ul->data;
-			if (strcmp(jid, user->jid) == 0) {
-				g_free(jid);
-				return user->name;
-			}
-		}
-	}
-	g_free(jid);
-	return NULL;
+	user = rosters_find_user(server->roster, full_jid, NULL, NULL);
+	return user != NULL ? user->name : NULL;
+}
+
+int
+rosters_count(XMPP_SERVER_REC *server, XMPP_ROSTER_GROUP_REC *group, int show)
+{
+	g_return_val_if_fail(IS_XMPP_SERVER(server), 0);
+	g_return_val_if_fail(show >= 0 && show < XMPP_PRESENCE_SHOW_LEN, 0);
+	return group != NULL ? group->counts[show] : server->roster_counts[show];
+}
+
+/* contacts with at least one available resource */
+int
+rosters_count_online(XMPP_SERVER_REC *server, XMPP_ROSTER_GROUP_REC *group)
+{
+	int *counts, show, n;
+
+	g_return_val_if_fail(IS_XMPP_SERVER(server), 0);
+	counts = group != NULL ? group->counts : server->roster_counts;
+	for (n = 0, show = XMPP_PRESENCE_XA; show < XMPP_PRESENCE_SHOW_LEN;
+	    ++show)
+		n += counts[show];
+	return n;
 }
 
 int
 xmpp_get_show(const char *show)
 {
-	if (show != NULL && *show != '\0') {
-		if (g_ascii_strcasecmp(show,
-		    xmpp_presence_show[XMPP_PRESENCE_CHAT]) == 0)
-			return XMPP_PRESENCE_CHAT;
-		else if (g_ascii_strcasecmp(show,
-		    xmpp_presence_show[XMPP_PRESENCE_DND]) == 0)
-			return XMPP_PRESENCE_DND;
-		else if (g_ascii_strcasecmp(show,
-		    xmpp_presence_show[XMPP_PRESENCE_XA]) == 0)
-			return XMPP_PRESENCE_XA;
-		else if (g_ascii_strcasecmp(show,
-		    xmpp_presence_show[XMPP_PRESENCE_AWAY]) == 0)
-			return XMPP_PRESENCE_AWAY;
-		else if (g_ascii_strcasecmp(show,
-		    xmpp_presence_show[XMPP_PRESENCE_ONLINE]) == 0)
-			return XMPP_PRESENCE_AVAILABLE;
-	}
-	return XMPP_PRESENCE_AVAILABLE;
+	return xmpp_keyword(XMPP_KEYWORDS_SHOW, show, XMPP_PRESENCE_AVAILABLE);
 }
@@ -11,6 +11,9 @@ XMPP_ROSTER_RESOURCE_REC *rosters_find_resource(GSList *, const char *);
 void		 rosters_reorder(XMPP_ROSTER_GROUP_REC *);
 char		*rosters_resolve_name(XMPP_SERVER_REC *, const char *);
 char		*rosters_get_name(XMPP_SERVER_REC *, const char *);
+int		 rosters_count(XMPP_SERVER_REC *, XMPP_ROSTER_GROUP_REC *, int);
+int		 rosters_count_online(XMPP_SERVER_REC *,
+		     XMPP_ROSTER_GROUP_REC *);
 int		 xmpp_get_show(const char *);
 __END_DECLS
 
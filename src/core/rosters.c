@@ -22,7 +22,10 @@
 #include "signals.h"
 
 #include "xmpp-servers.h"
+#include "jids.h"
+#include "keywords.h"
 #include "rosters-tools.h"
+#include "timeline.h"
 #include "tools.h"
 
 #define XMLNS_ROSTER "jabber:iq:roster"
@@ -156,6 +159,49 @@ cleanup_resource(gpointer data, gpointer user_data)
 	g_free(resource);
 }
 
+static int
+get_user_show(XMPP_ROSTER_USER_REC *user)
+{
+	if (user->resources == NULL)
+		return user->error ?
+		    XMPP_PRESENCE_ERROR : XMPP_PRESENCE_UNAVAILABLE;
+	return ((XMPP_ROSTER_RESOURCE_REC *)user->resources->data)->show;
+}
+
+/*
+ * Adds (n = 1) or removes (n = -1) the user from the presence counters of
+ * its group and of the server.
+ */
+static void
+count_user(XMPP_SERVER_REC *server, XMPP_ROSTER_GROUP_REC *group,
+    XMPP_ROSTER_USER_REC *user, int n)
+{
+	int show;
+
+	show = get_user_show(user);
+	group->counts[show] += n;
+	server->roster_counts[show] += n;
+}
+
+/*
+ * Moves the user to the counter of its current show, old_show being the
+ * show it was counted with.
+ */
+static void
+recount_user(XMPP_SERVER_REC *server, XMPP_ROSTER_GROUP_REC *group,
+    XMPP_ROSTER_USER_REC *user, int *old_show)
+{
+	int show;
+
+	if ((show = get_user_show(user)) == *old_show)
+		return;
+	group->counts[*old_show]--;
+	server->roster_counts[*old_show]--;
+	group->counts[show]++;
+	server->roster_counts[show]++;
+	*old_show = show;
+}
+
 static XMPP_ROSTER_USER_REC *
 create_user(const char *jid, const char *name)
 {
@@ -163,7 +209,7 @@ create_user(const char *jid, const char *name)
 
 	g_return_val_if_fail(jid != NULL, NULL);
 	user = g_new(XMPP_ROSTER_USER_REC, 1);
-	user->jid = g_strdup(jid);
+	user->jid = xmpp_jid_ref(jid);
 	user->name = g_strdup(name);
 	user->subscription = XMPP_SUBSCRIPTION_NONE;
 	user->error = FALSE;
@@ -182,7 +228,7 @@ cleanup_user(gpointer data, gpointer user_data)
 	g_slist_foreach(user->resources, cleanup_resource, NULL);
 	g_slist_free(user->resources);
 	g_free(user->name);
-	g_free(user->jid);
+	xmpp_jid_unref(user->jid);
 	g_free(user);
 }
 
@@ -191,7 +237,7 @@ create_group(const char *name)
 {
 	XMPP_ROSTER_GROUP_REC *group;
 
-	group = g_new(XMPP_ROSTER_GROUP_REC, 1);
+	group = g_new0(XMPP_ROSTER_GROUP_REC, 1);
 	group->name = g_strdup(name);
 	group->users = NULL;
 	return group;
@@ -219,6 +265,7 @@ roster_cleanup(XMPP_SERVER_REC *server)
 	g_slist_foreach(server->roster, cleanup_group, server);
 	g_slist_free(server->roster);
 	server->roster = NULL;
+	memset(server->roster_counts, 0, sizeof(server->roster_counts));
 	g_slist_foreach(server->my_resources, cleanup_resource, NULL);
 	g_slist_free(server->my_resources);
 	server->my_resources = NULL;
@@ -254,6 +301,7 @@ add_user(XMPP_SERVER_REC *server, const char *jid, const char *name,
 	group = find_or_add_group(server, group_name);
 	user = create_user(jid, name);
 	group->users = g_slist_append(group->users, user);
+	count_user(server, group, user, 1);
 	if (return_group != NULL)
 		*return_group = group;
 	return user;
@@ -268,8 +316,10 @@ move_user(XMPP_SERVER_REC *server, XMPP_ROSTER_USER_REC *user,
 	g_return_val_if_fail(IS_XMPP_SERVER(server), group);
         g_return_val_if_fail(user != NULL, group);
 	new_group = find_or_add_group(server, group_name);
+	count_user(server, group, user, -1);
 	group->users = g_slist_remove(group->users, user);
 	new_group->users = g_slist_append(new_group->users, user);
+	count_user(server, new_group, user, 1);
 	return new_group;
 }
 
@@ -277,23 +327,15 @@ static void
 update_subscription(XMPP_SERVER_REC *server, XMPP_ROSTER_USER_REC *user,
     XMPP_ROSTER_GROUP_REC *group, const char *subscription)
 {
+	int sub;
+
 	g_return_if_fail(IS_XMPP_SERVER(server));
 	g_return_if_fail(user != NULL);
 	g_return_if_fail(group != NULL);
-	if (subscription == NULL || g_ascii_strcasecmp(subscription,
-	    xmpp_subscription[XMPP_SUBSCRIPTION_NONE]) == 0)
-		user->subscription = XMPP_SUBSCRIPTION_NONE;
-	else if (g_ascii_strcasecmp(subscription,
-	    xmpp_subscription[XMPP_SUBSCRIPTION_FROM]) == 0)
-		user->subscription = XMPP_SUBSCRIPTION_FROM;
-	else if (g_ascii_strcasecmp(subscription,
-	    xmpp_subscription[XMPP_SUBSCRIPTION_TO]) == 0)
-		user->subscription = XMPP_SUBSCRIPTION_TO;
-	else if (g_ascii_strcasecmp(subscription,
-	    xmpp_subscription[XMPP_SUBSCRIPTION_BOTH]) == 0)
-		user->subscription = XMPP_SUBSCRIPTION_BOTH;
-	else if (g_ascii_strcasecmp(subscription,
-	    xmpp_subscription[XMPP_SUBSCRIPTION_REMOVE]) == 0) {
+	sub = subscription == NULL ? XMPP_SUBSCRIPTION_NONE :
+	    xmpp_keyword(XMPP_KEYWORDS_SUBSCRIPTION, subscription, -1);
+	if (sub == XMPP_SUBSCRIPTION_REMOVE) {
+		count_user(server, group, user, -1);
 		group->users = g_slist_remove(group->users, user);
 		cleanup_user(user, server);
 		/* remove empty group */
@@ -301,7 +343,8 @@ update_subscription(XMPP_SERVER_REC *server, XMPP_ROSTER_USER_REC *user,
 			server->roster = g_slist_remove(server->roster, group);
 			cleanup_group(group, server);
 		}
-	}
+	} else if (sub != -1)
+		user->subscription = sub;
 }
 
 static void
@@ -317,6 +360,7 @@ update_user(XMPP_SERVER_REC *server, const char *jid, const char *subscription,
 	if (user == NULL)
 		user = add_user(server, jid, name, group_name, &group);
 	else {
+		signal_emit("xmpp roster user changed", 2, server, user);
 		/* move to another group and sort it */
 		if ((group->name == NULL && group_name != NULL)
 		    || (group->name != NULL && group_name == NULL)
@@ -348,21 +392,24 @@ update_user_presence(XMPP_SERVER_REC *server, const char *full_jid,
 	XMPP_ROSTER_USER_REC *user;
 	XMPP_ROSTER_RESOURCE_REC *resource;
 	char *jid, *res;
-	int show, priority;
-	gboolean new, own;
+	int show, priority, old_show;
+	gboolean new, own, changed;
 
 	g_return_if_fail(IS_XMPP_SERVER(server));
 	g_return_if_fail(full_jid != NULL);
 	new = own = FALSE;
+	old_show = XMPP_PRESENCE_UNAVAILABLE;
 	jid = xmpp_strip_resource(full_jid);
 	res = xmpp_extract_resource(full_jid);
 	user = rosters_find_user(server->roster, jid, &group, NULL);
 	if (user == NULL) {
-		if (!(own = strcmp(jid, server->jid) == 0
+		if (!(own = xmpp_jid_equal(jid, server->jid)
 		     && strcmp(res, server->resource) != 0))
 			goto out;
-	} else
+	} else {
+		old_show = get_user_show(user);
 		user->error = FALSE;
+	}
 	/* find resource or create it if it doesn't exist */	
 	resource = rosters_find_resource(!own ?
 	    user->resources : server->my_resources, res);
@@ -381,8 +428,9 @@ update_user_presence(XMPP_SERVER_REC *server, const char *full_jid,
 	show = xmpp_get_show(show_str);
 	priority = (priority_str != NULL) ?
 	    atoi(priority_str) : resource->priority;
-	if (new || xmpp_presence_changed(show, resource->show, status,
-	    resource->status, priority, resource->priority)) {
+	changed = new || xmpp_presence_changed(show, resource->show, status,
+	    resource->status, priority, resource->priority);
+	if (changed) {
 		resource->show = show;
 		resource->status = g_strdup(status);
 		resource->priority = priority;
@@ -394,9 +442,12 @@ update_user_presence(XMPP_SERVER_REC *server, const char *full_jid,
 		} else
 			server->my_resources = g_slist_sort(
 			    server->my_resources, func_sort_resource);
+	}
+	if (!own)
+		recount_user(server, group, user, &old_show);
+	if (changed)
 		signal_emit("xmpp presence changed", 4, server, full_jid,
 		    resource->show, resource->status);
-	}
 
 out:
 	g_free(jid);
@@ -411,34 +462,45 @@ user_unavailable(XMPP_SERVER_REC *server, const char *full_jid,
 	XMPP_ROSTER_USER_REC *user;
 	XMPP_ROSTER_RESOURCE_REC *resource;
 	char *jid, *res;
+	int old_show;
 	gboolean own;
 
 	g_return_if_fail(IS_XMPP_SERVER(server));
 	g_return_if_fail(full_jid != NULL);
 	own = FALSE;
+	old_show = XMPP_PRESENCE_UNAVAILABLE;
 	jid = xmpp_strip_resource(full_jid);
 	res = xmpp_extract_resource(full_jid);
 	user = rosters_find_user(server->roster, jid, &group, NULL);
 	if (user == NULL) {
-		if (!(own = strcmp(jid, server->jid) == 0))
+		if (!(own = xmpp_jid_equal(jid, server->jid)))
 			goto out;
-	} else
+	} else {
+		old_show = get_user_show(user);
 		user->error = FALSE;
+	}
 	resource = rosters_find_resource(!own ?
 	    user->resources : server->my_resources, res);
-	if (resource == NULL)
-		goto out;
-	signal_emit("xmpp presence offline", 4, server, full_jid, jid, res);
-	signal_emit("xmpp presence changed", 4, server, full_jid,
-	    XMPP_PRESENCE_UNAVAILABLE, status);
-	if (!own)
-		user->resources = g_slist_remove(user->resources, resource);
-	else
-		server->my_resources = g_slist_remove(server->my_resources,
-		    resource);
-	cleanup_resource(resource, NULL);
-	if (!own) /* sort the group */
-		group->users = g_slist_sort(group->users, func_sort_user);
+	if (resource != NULL) {
+		signal_emit("xmpp presence offline", 4, server, full_jid,
+		    jid, res);
+		if (!own)
+			user->resources = g_slist_remove(user->resources,
+			    resource);
+		else
+			server->my_resources = g_slist_remove(
+			    server->my_resources, resource);
+		cleanup_resource(resource, NULL);
+		if (!own) /* sort the group */
+			group->users = g_slist_sort(group->users,
+			    func_sort_user);
+	}
+	if (user != NULL)
+		recount_user(server, group, user, &old_show);
+	/* the listeners see the roster and its counters updated */
+	if (resource != NULL)
+		signal_emit("xmpp presence changed", 4, server, full_jid,
+		    XMPP_PRESENCE_UNAVAILABLE, status);
 
 out:
 	g_free(jid);
@@ -452,27 +514,37 @@ user_presence_error(XMPP_SERVER_REC *server, const char *full_jid)
 	XMPP_ROSTER_USER_REC *user;
 	XMPP_ROSTER_RESOURCE_REC *resource;
 	char *jid, *res;
+	int old_show;
 	gboolean own;
 
 	g_return_if_fail(IS_XMPP_SERVER(server));
 	g_return_if_fail(full_jid != NULL);
 	own = FALSE;
+	old_show = XMPP_PRESENCE_UNAVAILABLE;
 	jid = xmpp_strip_resource(full_jid);
 	res = xmpp_extract_resource(full_jid);
 	user = rosters_find_user(server->roster, jid, &group, NULL);
-	if (user == NULL && !(own = strcmp(jid, server->jid) == 0))
+	if (user == NULL && !(own = xmpp_jid_equal(jid, server->jid)))
 		goto out;
+	if (user != NULL)
+		old_show = get_user_show(user);
 	resource = rosters_find_resource(!own ?
 	    user->resources : server->my_resources, res);
 	if (resource != NULL) {
 		resource->show = XMPP_PRESENCE_ERROR;
-		if (!own) /* sort the group */
+		if (!own) { /* sort the group */
 			group->users = g_slist_sort(group->users,
 			    func_sort_user);
+			recount_user(server, group, user, &old_show);
+		}
 		signal_emit("xmpp presence changed", 4, server, full_jid,
 		    XMPP_PRESENCE_ERROR, NULL);
-	} else if (user != NULL)
+	} else if (user != NULL) {
+		/* no presence changed, but the user is shown differently */
 		user->error = TRUE;
+		recount_user(server, group, user, &old_show);
+		signal_emit("xmpp roster user changed", 2, server, user);
+	}
 
 out:
 	g_free(jid);
@@ -541,6 +613,8 @@ sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
 	node = lm_find_node(lmsg->node, "query", "xmlns", XMLNS_ROSTER);
 	if (node == NULL)
 		return;
+	if (type == LM_MESSAGE_SUB_TYPE_RESULT)
+		xmpp_timeline_mark(server, "roster received");
 	for (item = node->children; item != NULL; item = item->next) {
 		if (strcmp(item->name, "item") != 0)
 			continue;
@@ -573,6 +647,7 @@ sig_connected(XMPP_SERVER_REC *server)
 	lm_message_node_set_attribute(node, "xmlns", "jabber:iq:roster");
 	signal_emit("xmpp send iq", 2, server, lmsg);
 	lm_message_unref(lmsg);
+	xmpp_timeline_mark(server, "roster requested");
 }
 
 void
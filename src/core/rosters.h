@@ -43,6 +43,7 @@ typedef struct _XMPP_ROSTER_USER_REC {
 typedef struct _XMPP_ROSTER_GROUP_REC {
 	char	*name;
 	GSList	*users;
+	int	 counts[XMPP_PRESENCE_SHOW_LEN];
 } XMPP_ROSTER_GROUP_REC;
 
 __BEGIN_DECLS
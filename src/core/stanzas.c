@@ -15,12 +15,42 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <string.h>
+
 #include "module.h"
 #include "settings.h"
 #include "signals.h"
 
 #include "xmpp-servers.h"
+#include "capture.h"
+#include "jids.h"
+#include "stanzas.h"
 #include "tools.h"
+#include "xep/blocking.h"
+
+#define XMLNS_EVENT		"jabber:x:event"
+#define XMLNS_CHATSTATES	"http://jabber.org/protocol/chatstates"
+#define XMLNS_DELAY		"urn:xmpp:delay"
+#define XMLNS_OLD_DELAY		"jabber:x:delay"
+#define XMLNS_DISCO_INFO	"http://jabber.org/protocol/disco#info"
+#define XMLNS_DISCO_ITEMS	"http://jabber.org/protocol/disco#items"
+#define XMLNS_MUC		"http://jabber.org/protocol/muc"
+#define XMLNS_MUC_USER		"http://jabber.org/protocol/muc#user"
+#define XMLNS_VCARD		"vcard-temp"
+#define XMLNS_VERSION		"jabber:iq:version"
+
+/* flush the queues without waiting for the main loop past this size */
+#define SEND_QUEUE_MAX	(32 * 1024)
+
+/* the flood buckets are counted in millionths of stanza */
+#define FLOOD_UNIT		G_USEC_PER_SEC
+/* the idle buckets are pruned past this number of senders */
+#define FLOOD_BUCKETS_MAX	1024
+
+struct queued_stanza {
+	char	*xml;
+	char	*dest;		/* canonical bare JID of the recipient */
+};
 
 static int message_types[] = {
 	LM_MESSAGE_TYPE_MESSAGE,
@@ -29,6 +59,281 @@ static int message_types[] = {
 	-1
 };
 
+static int send_max_latency;
+static int send_rate;
+static int send_burst;
+static int flood_rate;
+static int flood_burst;
+
+static gboolean
+has_child_xmlns(LmMessageNode *node, const char *xmlns)
+{
+	LmMessageNode *child;
+	const char *ns;
+
+	for (child = node->children; child != NULL; child = child->next) {
+		ns = lm_message_node_get_attribute(child, "xmlns");
+		if (ns != NULL && strcmp(ns, xmlns) == 0)
+			return TRUE;
+	}
+	return FALSE;
+}
+
+static int
+get_send_class(LmMessage *lmsg)
+{
+	LmMessageNode *node;
+
+	node = lmsg->node;
+	switch (lm_message_get_type(lmsg)) {
+	case LM_MESSAGE_TYPE_MESSAGE:
+		if (lm_message_node_get_child(node, "body") != NULL
+		    || lm_message_node_get_child(node, "subject") != NULL)
+			return XMPP_SEND_INTERACTIVE;
+		if (has_child_xmlns(node, XMLNS_CHATSTATES)
+		    || has_child_xmlns(node, XMLNS_EVENT))
+			return XMPP_SEND_BULK;
+		break;
+	case LM_MESSAGE_TYPE_PRESENCE:
+		/* directed available presences (the MUC broadcast), but
+		 * never the joins: they must stay ordered with the parts */
+		if (lm_message_get_sub_type(lmsg) == LM_MESSAGE_SUB_TYPE_AVAILABLE
+		    && lm_message_node_get_attribute(node, "to") != NULL
+		    && !has_child_xmlns(node, XMLNS_MUC))
+			return XMPP_SEND_BULK;
+		break;
+	case LM_MESSAGE_TYPE_IQ:
+		/* someone is waiting for our replies */
+		if (lm_message_get_sub_type(lmsg) == LM_MESSAGE_SUB_TYPE_RESULT
+		    || lm_message_get_sub_type(lmsg) == LM_MESSAGE_SUB_TYPE_ERROR)
+			return XMPP_SEND_INTERACTIVE;
+		if (lm_message_get_sub_type(lmsg) == LM_MESSAGE_SUB_TYPE_GET
+		    && (has_child_xmlns(node, XMLNS_DISCO_INFO)
+		    || has_child_xmlns(node, XMLNS_DISCO_ITEMS)
+		    || has_child_xmlns(node, XMLNS_VCARD)
+		    || has_child_xmlns(node, XMLNS_VERSION)))
+			return XMPP_SEND_BULK;
+		break;
+	default:
+		break;
+	}
+	return XMPP_SEND_NORMAL;
+}
+
+static void
+refill_tokens(XMPP_SERVER_REC *server)
+{
+	gint64 now;
+
+	now = g_get_monotonic_time();
+	if (server->send_refill_time == 0)
+		server->send_tokens = send_burst;
+	else
+		server->send_tokens += (now - server->send_refill_time)
+		    * send_rate / G_USEC_PER_SEC;
+	if (server->send_tokens > send_burst)
+		server->send_tokens = send_burst;
+	server->send_refill_time = now;
+}
+
+static gboolean
+throttle_func(XMPP_SERVER_REC *server)
+{
+	server->send_throttle_tag = 0;
+	stanzas_flush(server);
+	return FALSE;
+}
+
+static int *
+get_dest_counts(XMPP_SERVER_REC *server, const char *dest, gboolean create)
+{
+	int *counts;
+
+	if (server->send_dests == NULL) {
+		if (!create)
+			return NULL;
+		server->send_dests = g_hash_table_new_full(g_str_hash,
+		    g_str_equal, g_free, g_free);
+	}
+	counts = g_hash_table_lookup(server->send_dests, dest);
+	if (counts == NULL && create) {
+		counts = g_new0(int, XMPP_SEND_CLASSES);
+		g_hash_table_insert(server->send_dests, g_strdup(dest),
+		    counts);
+	}
+	return counts;
+}
+
+static void
+unindex_stanza(XMPP_SERVER_REC *server, struct queued_stanza *qs, int class)
+{
+	int *counts;
+	int i;
+
+	if ((counts = get_dest_counts(server, qs->dest, FALSE)) == NULL)
+		return;
+	--counts[class];
+	for (i = 0; i < XMPP_SEND_CLASSES; ++i)
+		if (counts[i] > 0)
+			return;
+	g_hash_table_remove(server->send_dests, qs->dest);
+}
+
+static void
+flush_queues(XMPP_SERVER_REC *server, gboolean force)
+{
+	GString *buf;
+	struct queued_stanza *qs;
+	gint64 len, need;
+	int i;
+	gboolean throttled;
+
+	if (server->send_idle_tag != 0) {
+		g_source_remove(server->send_idle_tag);
+		server->send_idle_tag = 0;
+	}
+	if (server->send_timeout_tag != 0) {
+		g_source_remove(server->send_timeout_tag);
+		server->send_timeout_tag = 0;
+	}
+	if (server->send_queued == 0)
+		return;
+	if (send_rate > 0)
+		refill_tokens(server);
+	buf = NULL;
+	throttled = FALSE;
+	need = 0;
+	for (i = 0; i < XMPP_SEND_CLASSES && !throttled; ++i) {
+		while ((qs = g_queue_peek_head(&server->send_queues[i]))
+		    != NULL) {
+			len = strlen(qs->xml);
+			/* interactive stanzas are never held back: the other
+			 * classes wait until the bucket is paid back */
+			need = MIN(len, send_burst);
+			if (!force && send_rate > 0
+			    && i != XMPP_SEND_INTERACTIVE
+			    && server->send_tokens < need) {
+				throttled = TRUE;
+				break;
+			}
+			g_queue_pop_head(&server->send_queues[i]);
+			unindex_stanza(server, qs, i);
+			if (buf == NULL)
+				buf = g_string_sized_new(
+				    MIN(server->send_queued, SEND_QUEUE_MAX));
+			g_string_append_len(buf, qs->xml, len);
+			server->send_tokens -= len;
+			server->send_queued -= len;
+			g_free(qs->xml);
+			g_free(qs->dest);
+			g_free(qs);
+		}
+	}
+	if (buf != NULL) {
+		if (server->lmconn != NULL
+		    && lm_connection_is_open(server->lmconn))
+			lm_connection_send_raw(server->lmconn, buf->str, NULL);
+		g_string_free(buf, TRUE);
+	}
+	if (throttled && server->send_throttle_tag == 0) {
+		server->send_throttle_tag = g_timeout_add(
+		    (need - server->send_tokens) * 1000 / send_rate + 1,
+		    (GSourceFunc)throttle_func, server);
+	}
+}
+
+void
+stanzas_flush(XMPP_SERVER_REC *server)
+{
+	g_return_if_fail(IS_XMPP_SERVER(server));
+	flush_queues(server, FALSE);
+}
+
+static gboolean
+flush_idle_func(XMPP_SERVER_REC *server)
+{
+	server->send_idle_tag = 0;
+	stanzas_flush(server);
+	return FALSE;
+}
+
+static gboolean
+flush_timeout_func(XMPP_SERVER_REC *server)
+{
+	server->send_timeout_tag = 0;
+	stanzas_flush(server);
+	return FALSE;
+}
+
+/* moves the stanzas for dest still waiting in the lower priority
+ * classes to the tail of class, in the order they would have been sent */
+static void
+promote_dest(XMPP_SERVER_REC *server, const char *dest, int *counts,
+    int class)
+{
+	GList *tmp, *next;
+	int i;
+
+	for (i = class + 1; i < XMPP_SEND_CLASSES; ++i) {
+		for (tmp = server->send_queues[i].head;
+		    tmp != NULL && counts[i] > 0; tmp = next) {
+			next = tmp->next;
+			if (strcmp(((struct queued_stanza *)tmp->data)->dest,
+			    dest) != 0)
+				continue;
+			g_queue_unlink(&server->send_queues[i], tmp);
+			g_queue_push_tail_link(&server->send_queues[class],
+			    tmp);
+			--counts[i];
+			++counts[class];
+		}
+	}
+}
+
+static void
+queue_stanza(XMPP_SERVER_REC *server, LmMessage *lmsg, char *xml)
+{
+	struct queued_stanza *qs;
+	const char *to;
+	int *counts;
+	int class, type;
+
+	qs = g_new(struct queued_stanza, 1);
+	qs->xml = xml;
+	to = lm_message_node_get_attribute(lmsg->node, "to");
+	to = to != NULL ? xmpp_jid_canonical(to) : "";
+	qs->dest = g_strndup(to, strcspn(to, "/"));
+	/* the stanzas for a recipient are sent in order, whatever their
+	 * class: a message never overtakes the join of its room and a
+	 * part never overtakes a presence. The stanzas queued before are
+	 * promoted rather than the new one held back, only the replies to
+	 * the requests may overtake them */
+	class = get_send_class(lmsg);
+	type = lm_message_get_sub_type(lmsg);
+	counts = get_dest_counts(server, qs->dest, TRUE);
+	if (lm_message_get_type(lmsg) != LM_MESSAGE_TYPE_IQ
+	    || (type != LM_MESSAGE_SUB_TYPE_RESULT
+	    && type != LM_MESSAGE_SUB_TYPE_ERROR))
+		promote_dest(server, qs->dest, counts, class);
+	g_queue_push_tail(&server->send_queues[class], qs);
+	++counts[class];
+	server->send_queued += strlen(xml);
+	/* while throttled, the bucket decides when the queues go out */
+	if (send_max_latency <= 0 || (server->send_queued >= SEND_QUEUE_MAX
+	    && server->send_throttle_tag == 0)) {
+		stanzas_flush(server);
+		return;
+	}
+	/* written once the pending events of this iteration are handled,
+	 * or after the max latency if the main loop never becomes idle */
+	if (server->send_idle_tag == 0)
+		server->send_idle_tag = g_idle_add(
+		    (GSourceFunc)flush_idle_func, server);
+	if (server->send_timeout_tag == 0)
+		server->send_timeout_tag = g_timeout_add(send_max_latency,
+		    (GSourceFunc)flush_timeout_func, server);
+}
+
 static void
 send_stanza(XMPP_SERVER_REC *server, LmMessage *lmsg)
 {
@@ -38,38 +343,200 @@ send_stanza(XMPP_SERVER_REC *server, LmMessage *lmsg)
 	g_return_if_fail(lmsg != NULL);
 	xml = lm_message_node_to_string(lmsg->node);
 	recoded = xmpp_recode_in(xml);
-	g_free(xml);
 	signal_emit("xmpp xml out", 2, server, recoded);
 	g_free(recoded);
-	lm_connection_send(server->lmconn, lmsg, NULL);
+	capture_stanza(server, xml, TRUE);
+	if (server->replaying) {
+		g_free(xml);
+		return;
+	}
+	queue_stanza(server, lmsg, xml);
 }
 
-static LmHandlerResult
-handle_stanza(LmMessageHandler *handler, LmConnection *connection,
-    LmMessage *lmsg, gpointer user_data)
+static void
+free_bucket(XMPP_FLOOD_REC *bucket)
+{
+	xmpp_jid_unref(bucket->jid);
+	g_free(bucket);
+}
+
+static void
+refill_bucket(XMPP_FLOOD_REC *bucket, gint64 now)
+{
+	bucket->tokens += (now - bucket->refill_time) * flood_rate;
+	if (bucket->tokens > (gint64)flood_burst * FLOOD_UNIT)
+		bucket->tokens = (gint64)flood_burst * FLOOD_UNIT;
+	bucket->refill_time = now;
+}
+
+static gboolean
+bucket_is_idle(gpointer key, XMPP_FLOOD_REC *bucket, gint64 *now)
+{
+	refill_bucket(bucket, *now);
+	return bucket->dropped == 0
+	    && bucket->tokens == (gint64)flood_burst * FLOOD_UNIT;
+}
+
+static XMPP_FLOOD_REC *
+get_bucket(XMPP_SERVER_REC *server, const char *jid, gsize len, gint64 now)
+{
+	XMPP_FLOOD_REC *bucket;
+	char *atom, *str;
+
+	if (server->flood_buckets == NULL)
+		server->flood_buckets = g_hash_table_new_full(g_direct_hash,
+		    g_direct_equal, NULL, (GDestroyNotify)free_bucket);
+	atom = xmpp_jid_lookup_len(jid, len);
+	if (atom != NULL
+	    && (bucket = g_hash_table_lookup(server->flood_buckets, atom))
+	    != NULL)
+		return bucket;
+	/* at most once a second, when many senders are active at once */
+	if (g_hash_table_size(server->flood_buckets) >= FLOOD_BUCKETS_MAX
+	    && now - server->flood_prune_time >= G_USEC_PER_SEC) {
+		g_hash_table_foreach_remove(server->flood_buckets,
+		    (GHRFunc)bucket_is_idle, &now);
+		server->flood_prune_time = now;
+	}
+	bucket = g_new0(XMPP_FLOOD_REC, 1);
+	str = g_strndup(jid, len);
+	bucket->jid = xmpp_jid_ref(str);
+	g_free(str);
+	bucket->tokens = (gint64)flood_burst * FLOOD_UNIT;
+	bucket->refill_time = now;
+	g_hash_table_insert(server->flood_buckets, bucket->jid, bucket);
+	return bucket;
+}
+
+static gboolean
+flood_report_func(XMPP_SERVER_REC *server)
+{
+	GHashTableIter iter;
+	XMPP_FLOOD_REC *bucket;
+
+	server->flood_report_tag = 0;
+	g_hash_table_iter_init(&iter, server->flood_buckets);
+	while (g_hash_table_iter_next(&iter, NULL, (gpointer *)&bucket)) {
+		if (bucket->dropped == 0)
+			continue;
+		signal_emit("xmpp flood", 3, server, bucket->jid,
+		    GINT_TO_POINTER(bucket->dropped));
+		bucket->dropped = 0;
+	}
+	return FALSE;
+}
+
+/*
+ * Token bucket per sender: the bare JID, or the occupant JID for the
+ * stanzas of rooms. Only messages and requests are limited: a dropped
+ * presence would leave the roster and the nicklists out of date. The
+ * stanzas dropped are reported once a second.
+ */
+static gboolean
+flood_limited(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from)
+{
+	XMPP_FLOOD_REC *bucket;
+	gint64 now;
+	gsize len;
+
+	if (flood_rate <= 0 || server->replaying)
+		return FALSE;
+	if (lm_message_get_type(lmsg) != LM_MESSAGE_TYPE_MESSAGE
+	    && (lm_message_get_type(lmsg) != LM_MESSAGE_TYPE_IQ
+	    || type != LM_MESSAGE_SUB_TYPE_GET))
+		return FALSE;
+	/* the history of a room and the offline messages come at once */
+	if (lm_message_get_type(lmsg) == LM_MESSAGE_TYPE_MESSAGE
+	    && (has_child_xmlns(lmsg->node, XMLNS_DELAY)
+	    || has_child_xmlns(lmsg->node, XMLNS_OLD_DELAY)))
+		return FALSE;
+	len = strcspn(from, "/");
+	if (from[len] != '\0' && (type == LM_MESSAGE_SUB_TYPE_GROUPCHAT
+	    || has_child_xmlns(lmsg->node, XMLNS_MUC_USER)))
+		len = strlen(from);
+	now = g_get_monotonic_time();
+	bucket = get_bucket(server, from, len, now);
+	refill_bucket(bucket, now);
+	if (bucket->tokens >= FLOOD_UNIT) {
+		bucket->tokens -= FLOOD_UNIT;
+		return FALSE;
+	}
+	bucket->dropped++;
+	bucket->total++;
+	server->flood_dropped++;
+	if (server->flood_report_tag == 0)
+		server->flood_report_tag = g_timeout_add(1000,
+		    (GSourceFunc)flood_report_func, server);
+	return TRUE;
+}
+
+static gboolean
+is_own(XMPP_SERVER_REC *server, const char *from)
+{
+	gsize len;
+
+	len = strcspn(from, "/");
+	return (g_ascii_strncasecmp(from, server->domain, len) == 0
+	    && server->domain[len] == '\0')
+	    || (g_ascii_strncasecmp(from, server->jid, len) == 0
+	    && server->jid[len] == '\0');
+}
+
+static gboolean
+drop_stanza(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from)
+{
+	/* the replies to our requests are never dropped, nor what comes
+	 * from our server or our account */
+	if (*from == '\0' || is_own(server, from)
+	    || (lm_message_get_type(lmsg) == LM_MESSAGE_TYPE_IQ
+	    && (type == LM_MESSAGE_SUB_TYPE_RESULT
+	    || type == LM_MESSAGE_SUB_TYPE_ERROR)))
+		return FALSE;
+	return xmpp_blocked(server, from)
+	    || flood_limited(server, lmsg, type, from);
+}
+
+/*
+ * Decodes a received stanza and hands it to the "xmpp recv" handlers,
+ * or to nothing for a replay: the handlers would open windows and change
+ * the roster and rooms of the live session.
+ */
+static void
+receive_stanza(XMPP_SERVER_REC *server, LmMessage *lmsg, gboolean replay)
 {
-	XMPP_SERVER_REC *server;
 	int type;
-	const char *id;
-	char *from, *to, *raw, *xml;
+	const char *id, *raw, *from, *to;
+	char *xml, *free_raw, *free_from, *free_to;
 
-	if ((server = XMPP_SERVER(user_data)) == NULL)
-		return LM_HANDLER_RESULT_REMOVE_MESSAGE;
+	type = lm_message_get_sub_type(lmsg);
+	from = xmpp_recode_in_nocopy(
+	    lm_message_node_get_attribute(lmsg->node, "from"), &free_from);
+	if (from == NULL)
+		from = "";
+	/* blocked, ignored and flooding senders cost a lookup, nothing
+	 * more */
+	if (drop_stanza(server, lmsg, type, from)) {
+		g_free(free_from);
+		return;
+	}
 	xml = lm_message_node_to_string(lmsg->node);
-	raw = xmpp_recode_in(xml);
-	signal_emit("xmpp xml in", 2, server, raw);
+	raw = xmpp_recode_in_nocopy(xml, &free_raw);
+	if (!replay)
+		signal_emit("xmpp xml in", 2, server, raw);
+	capture_stanza(server, xml, FALSE);
 	g_free(xml);
-	g_free(raw);
-	type = lm_message_get_sub_type(lmsg);
+	g_free(free_raw);
 	id = lm_message_node_get_attribute(lmsg->node, "id");
 	if (id == NULL)
 		id = "";
-	from = xmpp_recode_in(lm_message_node_get_attribute(lmsg->node, "from"));
-	if (from == NULL)
-		from = g_strdup("");
-	to = xmpp_recode_in(lm_message_node_get_attribute(lmsg->node, "to"));
+	to = xmpp_recode_in_nocopy(
+	    lm_message_node_get_attribute(lmsg->node, "to"), &free_to);
 	if (to == NULL)
-		to = g_strdup("");
+		to = "";
+	if (replay)
+		goto out;
 	switch(lm_message_get_type(lmsg)) {
 	case LM_MESSAGE_TYPE_MESSAGE:
 		signal_emit("xmpp recv message", 6,
@@ -88,8 +555,31 @@ handle_stanza(LmMessageHandler *handler, LmConnection *connection,
 		    server, lmsg, type, id, from, to);
 		break;
 	}
-	g_free(from);
-	g_free(to);
+out:
+	g_free(free_from);
+	g_free(free_to);
+}
+
+void
+stanzas_dispatch(XMPP_SERVER_REC *server, LmMessage *lmsg)
+{
+	receive_stanza(server, lmsg, FALSE);
+}
+
+void
+stanzas_replay(XMPP_SERVER_REC *server, LmMessage *lmsg)
+{
+	receive_stanza(server, lmsg, TRUE);
+}
+
+static LmHandlerResult
+handle_stanza(LmMessageHandler *handler, LmConnection *connection,
+    LmMessage *lmsg, gpointer user_data)
+{
+	XMPP_SERVER_REC *server;
+
+	if ((server = XMPP_SERVER(user_data)) != NULL)
+		stanzas_dispatch(server, lmsg);
 	return LM_HANDLER_RESULT_REMOVE_MESSAGE;
 }
 
@@ -130,22 +620,72 @@ register_stanzas(XMPP_SERVER_REC *server)
 	}
 }
 
+static void
+sig_disconnected(XMPP_SERVER_REC *server)
+{
+	if (!IS_XMPP_SERVER(server))
+		return;
+	/* the unavailable presence may still be waiting in the queues */
+	flush_queues(server, TRUE);
+	if (server->send_throttle_tag != 0) {
+		g_source_remove(server->send_throttle_tag);
+		server->send_throttle_tag = 0;
+	}
+	server->send_refill_time = 0;
+	if (server->send_dests != NULL) {
+		g_hash_table_destroy(server->send_dests);
+		server->send_dests = NULL;
+	}
+	if (server->flood_report_tag != 0) {
+		g_source_remove(server->flood_report_tag);
+		server->flood_report_tag = 0;
+	}
+	if (server->flood_buckets != NULL) {
+		g_hash_table_destroy(server->flood_buckets);
+		server->flood_buckets = NULL;
+	}
+	unregister_stanzas(server);
+}
+
+static void
+read_settings(void)
+{
+	send_max_latency = settings_get_time("xmpp_send_max_latency");
+	send_rate = settings_get_int("xmpp_send_rate");
+	send_burst = settings_get_int("xmpp_send_burst");
+	if (send_burst <= 0)
+		send_burst = 1;
+	flood_rate = settings_get_int("xmpp_flood_rate");
+	flood_burst = settings_get_int("xmpp_flood_burst");
+	if (flood_burst <= 0)
+		flood_burst = 1;
+}
+
 void
 stanzas_init(void)
 {
 	signal_add("server connecting", register_stanzas);
-	signal_add_first("server disconnected", unregister_stanzas);
+	signal_add_first("server disconnected", sig_disconnected);
+	signal_add("setup changed", read_settings);
 	signal_add_last("xmpp send message", send_stanza); 
 	signal_add_last("xmpp send presence", send_stanza); 
 	signal_add_last("xmpp send iq", send_stanza); 
 	signal_add_last("xmpp send others", send_stanza); 
+
+	settings_add_time("xmpp", "xmpp_send_max_latency", "50msec");
+	settings_add_int("xmpp", "xmpp_send_rate", 0);
+	settings_add_int("xmpp", "xmpp_send_burst", 4096);
+	settings_add_int("xmpp", "xmpp_flood_rate", 0);
+	settings_add_int("xmpp", "xmpp_flood_burst", 30);
+	read_settings();
 }
 
 void
 stanzas_deinit(void)
 {
 	signal_remove("server connecting", register_stanzas);
-	signal_remove("server disconnected", unregister_stanzas);
+	signal_remove("server disconnected", sig_disconnected);
+	signal_remove("setup changed", read_settings);
 	signal_remove("xmpp send message", send_stanza); 
 	signal_remove("xmpp send presence", send_stanza); 
 	signal_remove("xmpp send iq", send_stanza); 
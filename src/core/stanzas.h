@@ -1,7 +1,20 @@
 #ifndef __STANZAS_H
 #define __STANZAS_H
 
+/* the ingress limiter of a sender */
+typedef struct _XMPP_FLOOD_REC {
+	char	*jid;
+	gint64	 tokens;
+	gint64	 refill_time;
+	int	 dropped;	/* since the last report */
+	int	 total;
+} XMPP_FLOOD_REC;
+
 __BEGIN_DECLS
+void	stanzas_flush(XMPP_SERVER_REC *);
+void	stanzas_dispatch(XMPP_SERVER_REC *, LmMessage *);
+void	stanzas_replay(XMPP_SERVER_REC *, LmMessage *);
+
 void	stanzas_init(void);
 void	stanzas_deinit(void);
 __END_DECLS
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Timeline of the connection: monotonic time of each phase, from the
+ * lookup of the server to the rooms being joined
+ */
+
+#include "module.h"
+#include "channels.h"
+#include "signals.h"
+
+#include "xmpp-servers.h"
+#include "timeline.h"
+
+/* the marks past this size are dropped (many rooms joined) */
+#define TIMELINE_MAX	256
+
+static void
+free_mark(XMPP_TIMELINE_REC *mark)
+{
+	g_free(mark->phase);
+	g_free(mark);
+}
+
+static void
+timeline_cleanup(XMPP_SERVER_REC *server)
+{
+	g_slist_free_full(server->timeline, (GDestroyNotify)free_mark);
+	server->timeline = NULL;
+	server->timeline_length = 0;
+	server->timeline_presence = FALSE;
+}
+
+void
+xmpp_timeline_mark(XMPP_SERVER_REC *server, const char *phase)
+{
+	XMPP_TIMELINE_REC *mark;
+
+	g_return_if_fail(IS_XMPP_SERVER(server));
+	g_return_if_fail(phase != NULL);
+	if (server->replaying || server->timeline_length >= TIMELINE_MAX)
+		return;
+	mark = g_new(XMPP_TIMELINE_REC, 1);
+	mark->phase = g_strdup(phase);
+	mark->time = g_get_monotonic_time();
+	/* the most recent first */
+	server->timeline = g_slist_prepend(server->timeline, mark);
+	server->timeline_length++;
+}
+
+static void
+sig_server_looking(XMPP_SERVER_REC *server)
+{
+	if (!IS_XMPP_SERVER(server))
+		return;
+	timeline_cleanup(server);
+	xmpp_timeline_mark(server, "lookup");
+}
+
+static void
+sig_server_connecting(XMPP_SERVER_REC *server)
+{
+	if (IS_XMPP_SERVER(server))
+		xmpp_timeline_mark(server, "stream opened");
+}
+
+static void
+sig_server_connected(XMPP_SERVER_REC *server)
+{
+	if (IS_XMPP_SERVER(server))
+		xmpp_timeline_mark(server, "server connected");
+}
+
+static void
+sig_recv_presence(XMPP_SERVER_REC *server)
+{
+	if (server->timeline_presence)
+		return;
+	server->timeline_presence = TRUE;
+	xmpp_timeline_mark(server, "first presence");
+}
+
+static void
+sig_channel_joined(CHANNEL_REC *channel)
+{
+	XMPP_SERVER_REC *server;
+	char *phase;
+
+	if ((server = XMPP_SERVER(channel->server)) == NULL)
+		return;
+	phase = g_strconcat("joined ", channel->name, (void *)NULL);
+	xmpp_timeline_mark(server, phase);
+	g_free(phase);
+}
+
+static void
+sig_server_destroyed(XMPP_SERVER_REC *server)
+{
+	if (IS_XMPP_SERVER(server))
+		timeline_cleanup(server);
+}
+
+void
+timeline_init(void)
+{
+	signal_add_first("server looking", sig_server_looking);
+	signal_add_first("server connecting", sig_server_connecting);
+	signal_add_first("server connected", sig_server_connected);
+	signal_add_first("xmpp recv presence", sig_recv_presence);
+	signal_add("channel joined", sig_channel_joined);
+	signal_add("server destroyed", sig_server_destroyed);
+}
+
+void
+timeline_deinit(void)
+{
+	signal_remove("server looking", sig_server_looking);
+	signal_remove("server connecting", sig_server_connecting);
+	signal_remove("server connected", sig_server_connected);
+	signal_remove("xmpp recv presence", sig_recv_presence);
+	signal_remove("channel joined", sig_channel_joined);
+	signal_remove("server destroyed", sig_server_destroyed);
+}
@@ -0,0 +1,16 @@
+#ifndef __TIMELINE_H
+#define __TIMELINE_H
+
+typedef struct _XMPP_TIMELINE_REC {
+	char	*phase;
+	gint64	 time;
+} XMPP_TIMELINE_REC;
+
+__BEGIN_DECLS
+void	xmpp_timeline_mark(XMPP_SERVER_REC *, const char *);
+
+void	timeline_init(void);
+void	timeline_deinit(void);
+__END_DECLS
+
+#endif
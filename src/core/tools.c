@@ -27,52 +27,168 @@
 
 static const char *utf8_charset = "UTF-8";
 
-static gboolean
-xmpp_get_local_charset(const char **charset)
+/* converters cached until the next "setup changed" */
+static gboolean charset_loaded;
+static gboolean local_utf8;
+static char *local_charset;
+static char *local_charset_in;
+static GIConv iconv_out = (GIConv)-1;
+static GIConv iconv_in = (GIConv)-1;
+
+#define WORD_ONES	((unsigned long)-1 / 0xff)
+#define WORD_HIGHS	(WORD_ONES * 0x80)
+
+static void
+unload_charset(void)
+{
+	if (iconv_out != (GIConv)-1)
+		g_iconv_close(iconv_out);
+	if (iconv_in != (GIConv)-1)
+		g_iconv_close(iconv_in);
+	iconv_out = iconv_in = (GIConv)-1;
+	g_free(local_charset);
+	g_free(local_charset_in);
+	local_charset = local_charset_in = NULL;
+	charset_loaded = FALSE;
+}
+
+static void
+load_charset(void)
+{
+	const char *charset;
+
+	if (charset_loaded)
+		return;
+	charset = settings_get_str("term_charset");
+	if (is_valid_charset(charset))
+		local_utf8 = g_ascii_strcasecmp(charset, utf8_charset) == 0;
+	else
+		local_utf8 = g_get_charset(&charset);
+	if (!local_utf8 && charset != NULL) {
+		local_charset = g_strdup(charset);
+		local_charset_in = settings_get_bool("recode_transliterate")
+		    && g_ascii_strcasecmp(charset, "//TRANSLIT") != 0 ?
+		    g_strconcat(charset, "//TRANSLIT", (void *)NULL) :
+		    g_strdup(charset);
+		iconv_out = g_iconv_open(utf8_charset, local_charset);
+		iconv_in = g_iconv_open(local_charset_in, utf8_charset);
+	}
+	charset_loaded = TRUE;
+}
+
+#define TEXT_NON_ASCII		0x01
+#define TEXT_FORMAT_CODES	0x02
+
+/* returns the flags for one byte */
+static int
+scan_byte(unsigned char c)
+{
+	if (c & 0x80)
+		return TEXT_NON_ASCII;
+	/* any control character may be one of irssi's format codes */
+	if (c < 32 && c != '\t' && c != '\n' && c != '\r')
+		return TEXT_FORMAT_CODES;
+	return 0;
+}
+
+/*
+ * Tells whether the len bytes of str have 8 bits characters or irssi
+ * format codes. Whole words are checked at once and only the words with
+ * a high bit set or a byte lower than 32 are looked at byte per byte; the
+ * tail shorter than a word is always looked at byte per byte, so nothing
+ * is read past the end of the string.
+ */
+static int
+scan_text(const char *str, gsize len)
 {
-	*charset = settings_get_str("term_charset");
-	if (is_valid_charset(*charset))
-		return (g_ascii_strcasecmp(*charset, utf8_charset) == 0);
-	return g_get_charset(charset);
+	const char *p, *end;
+	unsigned long v;
+	int flags;
+	gsize i;
+
+	flags = 0;
+	end = str + len;
+	for (p = str; (gsize)(end - p) >= sizeof(v); p += sizeof(v)) {
+		memcpy(&v, p, sizeof(v));
+		if ((((v - WORD_ONES * 32) & ~v) | v) & WORD_HIGHS) {
+			for (i = 0; i < sizeof(v); ++i)
+				flags |= scan_byte(p[i]);
+			if (flags == (TEXT_NON_ASCII | TEXT_FORMAT_CODES))
+				return flags;
+		}
+	}
+	for (; p < end; ++p)
+		flags |= scan_byte(*p);
+	return flags;
+}
+
+static char *
+convert(const char *str, GIConv cd, const char *to, const char *from)
+{
+	char *recoded;
+
+	recoded = NULL;
+	if (cd != (GIConv)-1)
+		recoded = g_convert_with_iconv(str, -1, cd, NULL, NULL, NULL);
+	/* invalid sequences: let glib find the fallbacks */
+	if (recoded == NULL)
+		recoded = g_convert_with_fallback(str, -1, to, from, NULL,
+		    NULL, NULL, NULL);
+	return recoded;
 }
 
 char *
 xmpp_recode_out(const char *str)
 {
-	const char *charset;
 	char *recoded, *stripped;
+	int flags;
 
 	if (str == NULL || *str == '\0')
 		return NULL;
 	recoded = stripped = NULL;
-	signal_emit("xmpp formats strip codes", 2, str, &stripped);
-	if (stripped != NULL) 
-		str = stripped;
-	if (!xmpp_get_local_charset(&charset) && charset != NULL)
-		recoded = g_convert_with_fallback(str, -1, utf8_charset,
-		    charset, NULL, NULL, NULL, NULL);
+	flags = scan_text(str, strlen(str));
+	/* most texts don't have anything to strip */
+	if (flags & TEXT_FORMAT_CODES) {
+		signal_emit("xmpp formats strip codes", 2, str, &stripped);
+		if (stripped != NULL) {
+			str = stripped;
+			flags = scan_text(str, strlen(str));
+		}
+	}
+	load_charset();
+	if (!local_utf8 && local_charset != NULL && (flags & TEXT_NON_ASCII))
+		recoded = convert(str, iconv_out, utf8_charset, local_charset);
 	recoded = recoded != NULL ? recoded : g_strdup(str);
 	g_free(stripped);
 	return recoded;
 }
 
+/*
+ * Returns str itself when it doesn't need to be converted, otherwise the
+ * converted string, which is also stored in *tofree.
+ */
+const char *
+xmpp_recode_in_nocopy(const char *str, char **tofree)
+{
+	*tofree = NULL;
+	if (str == NULL || *str == '\0')
+		return NULL;
+	load_charset();
+	if (local_utf8 || local_charset == NULL
+	    || (scan_text(str, strlen(str)) & TEXT_NON_ASCII) == 0)
+		return str;
+	*tofree = convert(str, iconv_in, local_charset_in, utf8_charset);
+	return *tofree != NULL ? *tofree : str;
+}
+
 char *
 xmpp_recode_in(const char *str)
 {
-	const char *charset;
-	char *recoded, *to = NULL;
+	const char *recoded;
+	char *tofree;
 
-	if (str == NULL || *str == '\0')
-		return NULL;
-	if (xmpp_get_local_charset(&charset) || charset == NULL)
-		return g_strdup(str);
-	if (settings_get_bool("recode_transliterate") &&
-	    g_ascii_strcasecmp(charset, "//TRANSLIT") != 0)
-		charset = to = g_strconcat(charset ,"//TRANSLIT", (void *)NULL);
-	recoded = g_convert_with_fallback(str, -1, charset, utf8_charset, NULL,
-	    NULL, NULL, NULL);
-	g_free(to);
-	return (recoded != NULL) ? recoded : g_strdup(str);
+	recoded = xmpp_recode_in_nocopy(str, &tofree);
+	return tofree != NULL ? tofree : g_strdup(recoded);
 }
 
 char *
@@ -165,3 +281,16 @@ xmpp_presence_changed(const int show, const int old_show, const char *status,
 	    && strcmp(status, old_status) != 0)
 	    || (priority != old_priority);
 }
+
+void
+tools_init(void)
+{
+	signal_add("setup changed", (SIGNAL_FUNC)unload_charset);
+}
+
+void
+tools_deinit(void)
+{
+	signal_remove("setup changed", (SIGNAL_FUNC)unload_charset);
+	unload_charset();
+}
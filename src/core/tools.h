@@ -4,6 +4,7 @@
 __BEGIN_DECLS
 char	*xmpp_recode_out(const char *);
 char	*xmpp_recode_in(const char *);
+const char *xmpp_recode_in_nocopy(const char *, char **);
 
 char	*xmpp_find_resource_sep(const char *);
 char	*xmpp_extract_resource(const char *);
@@ -15,6 +16,9 @@ gboolean xmpp_have_resource(const char *);
 gboolean xmpp_priority_out_of_bound(const int);
 gboolean xmpp_presence_changed(const int, const int, const char *,
 	     const char *, const int, const int);
+
+void	tools_init(void);
+void	tools_deinit(void);
 __END_DECLS
 
 #endif
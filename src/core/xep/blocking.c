@@ -0,0 +1,411 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/*
+ * XEP-0191: Blocking Command
+ * and local ignores
+ *
+ * The JIDs blocked on the server and the JIDs ignored with /IGNORE for
+ * every level are kept in one table per server, so the stanzas they send
+ * are dropped on reception before any module handles them.
+ */
+
+#include <string.h>
+
+#include "module.h"
+#include "ignore.h"
+#include "levels.h"
+#include "signals.h"
+
+#include "xmpp-servers.h"
+#include "xmpp-commands.h"
+#include "disco.h"
+#include "iq.h"
+#include "jids.h"
+#include "rosters-tools.h"
+#include "tools.h"
+#include "blocking.h"
+
+#define XMLNS_BLOCKING "urn:xmpp:blocking"
+
+enum {
+	BLOCKED_SERVER	= 1 << 0,	/* in the blocklist of the server */
+	BLOCKED_IGNORE	= 1 << 1	/* ignored locally */
+};
+
+static GSList *supported_servers;
+
+static void
+block_add(XMPP_SERVER_REC *server, const char *jid, int flag)
+{
+	char *atom;
+	int flags;
+
+	if (server->blocked == NULL)
+		server->blocked = g_hash_table_new_full(g_direct_hash,
+		    g_direct_equal, (GDestroyNotify)xmpp_jid_unref, NULL);
+	/* the table unrefs the key again if the JID is already in it */
+	atom = xmpp_jid_ref(jid);
+	flags = GPOINTER_TO_INT(g_hash_table_lookup(server->blocked, atom));
+	g_hash_table_insert(server->blocked, atom,
+	    GINT_TO_POINTER(flags | flag));
+}
+
+static void
+block_remove(XMPP_SERVER_REC *server, const char *jid, int flag)
+{
+	char *atom;
+	int flags;
+
+	if (server->blocked == NULL
+	    || (atom = xmpp_jid_lookup(jid)) == NULL)
+		return;
+	flags = GPOINTER_TO_INT(g_hash_table_lookup(server->blocked, atom))
+	    & ~flag;
+	if (flags != 0)
+		g_hash_table_insert(server->blocked, xmpp_jid_ref(atom),
+		    GINT_TO_POINTER(flags));
+	else
+		g_hash_table_remove(server->blocked, atom);
+}
+
+static gboolean
+clear_flag(gpointer key, gpointer value, gpointer flag)
+{
+	return (GPOINTER_TO_INT(value) & ~GPOINTER_TO_INT(flag)) == 0;
+}
+
+static void
+block_clear(XMPP_SERVER_REC *server, int flag)
+{
+	GHashTableIter iter;
+	gpointer key, value;
+
+	if (server->blocked == NULL)
+		return;
+	g_hash_table_foreach_remove(server->blocked, clear_flag,
+	    GINT_TO_POINTER(flag));
+	g_hash_table_iter_init(&iter, server->blocked);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		g_hash_table_iter_replace(&iter,
+		    GINT_TO_POINTER(GPOINTER_TO_INT(value) & ~flag));
+}
+
+static gboolean
+lookup_len(XMPP_SERVER_REC *server, const char *jid, gsize len)
+{
+	char *atom;
+
+	return (atom = xmpp_jid_lookup_len(jid, len)) != NULL
+	    && g_hash_table_lookup(server->blocked, atom) != NULL;
+}
+
+/*
+ * Checks the JIDs the sender matches, in the order of XEP-0191: its full
+ * JID, its bare JID, its domain with its resource and its domain
+ */
+gboolean
+xmpp_blocked(XMPP_SERVER_REC *server, const char *jid)
+{
+	const char *domain;
+	gsize len, full_len;
+
+	if (server->blocked == NULL || *jid == '\0')
+		return FALSE;
+	len = strcspn(jid, "/");
+	full_len = len + strlen(jid + len);
+	if (full_len != len && lookup_len(server, jid, full_len))
+		return TRUE;
+	if (lookup_len(server, jid, len))
+		return TRUE;
+	if ((domain = memchr(jid, '@', len)) == NULL)
+		return FALSE;
+	domain++;
+	if (full_len != len
+	    && lookup_len(server, domain, full_len - (domain - jid)))
+		return TRUE;
+	return lookup_len(server, domain, len - (domain - jid));
+}
+
+/* an ignore of every level for an exact JID */
+static gboolean
+ignore_is_jid(IGNORE_REC *rec, XMPP_SERVER_REC *server)
+{
+	return !rec->exception && rec->channels == NULL
+	    && rec->pattern == NULL && rec->mask != NULL
+	    && (rec->level & MSGLEVEL_ALL) == MSGLEVEL_ALL
+	    && strpbrk(rec->mask, "*?!") == NULL
+	    && (rec->servertag == NULL
+	    || g_ascii_strcasecmp(rec->servertag, server->tag) == 0);
+}
+
+static void
+read_ignores(XMPP_SERVER_REC *server)
+{
+	GSList *tmp;
+
+	block_clear(server, BLOCKED_IGNORE);
+	for (tmp = ignores; tmp != NULL; tmp = tmp->next)
+		if (ignore_is_jid(tmp->data, server))
+			block_add(server, ((IGNORE_REC *)tmp->data)->mask,
+			    BLOCKED_IGNORE);
+}
+
+static void
+sig_ignores_changed(void)
+{
+	GSList *tmp;
+
+	for (tmp = servers; tmp != NULL; tmp = tmp->next)
+		if (IS_XMPP_SERVER(tmp->data))
+			read_ignores(XMPP_SERVER(tmp->data));
+}
+
+static void
+read_items(XMPP_SERVER_REC *server, LmMessageNode *node, gboolean block)
+{
+	LmMessageNode *item;
+	char *jid;
+
+	for (item = node->children; item != NULL; item = item->next) {
+		if (strcmp(item->name, "item") != 0)
+			continue;
+		jid = xmpp_recode_in(lm_message_node_get_attribute(item,
+		    "jid"));
+		if (jid == NULL)
+			continue;
+		if (block)
+			block_add(server, jid, BLOCKED_SERVER);
+		else
+			block_remove(server, jid, BLOCKED_SERVER);
+		g_free(jid);
+	}
+}
+
+static void
+blocklist_reply(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from, gpointer user_data)
+{
+	LmMessageNode *node;
+
+	if (lmsg == NULL || type != LM_MESSAGE_SUB_TYPE_RESULT)
+		return;
+	/* <blocklist xmlns='urn:xmpp:blocking'>
+	 *   <item jid='jid'/>
+	 * </blocklist> */
+	node = lm_find_node(lmsg->node, "blocklist", XMLNS, XMLNS_BLOCKING);
+	if (node == NULL)
+		return;
+	block_clear(server, BLOCKED_SERVER);
+	read_items(server, node, TRUE);
+}
+
+static void
+request_blocklist(XMPP_SERVER_REC *server)
+{
+	LmMessage *lmsg;
+	LmMessageNode *node;
+
+	lmsg = lm_message_new_with_sub_type(NULL, LM_MESSAGE_TYPE_IQ,
+	    LM_MESSAGE_SUB_TYPE_GET);
+	node = lm_message_node_add_child(lmsg->node, "blocklist", NULL);
+	lm_message_node_set_attribute(node, XMLNS, XMLNS_BLOCKING);
+	xmpp_iq_send(server, lmsg, 0, blocklist_reply, NULL, NULL);
+	lm_message_unref(lmsg);
+}
+
+static void
+block_reply(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from, gpointer user_data)
+{
+	/* the blocklist itself is updated by the push of the server */
+	if (lmsg == NULL || type != LM_MESSAGE_SUB_TYPE_RESULT)
+		xmpp_iq_report(server, lmsg, from, user_data);
+}
+
+static void
+send_block(XMPP_SERVER_REC *server, const char *name, const char *jid)
+{
+	LmMessage *lmsg;
+	LmMessageNode *node, *item;
+	char *recoded;
+
+	lmsg = lm_message_new_with_sub_type(NULL, LM_MESSAGE_TYPE_IQ,
+	    LM_MESSAGE_SUB_TYPE_SET);
+	node = lm_message_node_add_child(lmsg->node, name, NULL);
+	lm_message_node_set_attribute(node, XMLNS, XMLNS_BLOCKING);
+	item = lm_message_node_add_child(node, "item", NULL);
+	recoded = xmpp_recode_out(jid);
+	lm_message_node_set_attribute(item, "jid", recoded);
+	g_free(recoded);
+	xmpp_iq_send(server, lmsg, 0, block_reply, (gpointer)name, NULL);
+	lm_message_unref(lmsg);
+}
+
+static void
+send_result(XMPP_SERVER_REC *server, const char *id)
+{
+	LmMessage *lmsg;
+
+	lmsg = lm_message_new_with_sub_type(NULL, LM_MESSAGE_TYPE_IQ,
+	    LM_MESSAGE_SUB_TYPE_RESULT);
+	lm_message_node_set_attribute(lmsg->node, "id", id);
+	signal_emit("xmpp send iq", 2, server, lmsg);
+	lm_message_unref(lmsg);
+}
+
+static void
+sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
+    const char *id, const char *from, const char *to)
+{
+	LmMessageNode *node;
+
+	/* the pushes come from our own account */
+	if (type != LM_MESSAGE_SUB_TYPE_SET
+	    || (*from != '\0' && !xmpp_jid_equal(from, server->jid)))
+		return;
+	/* <block xmlns='urn:xmpp:blocking'>
+	 *   <item jid='jid'/>
+	 * </block> */
+	if ((node = lm_find_node(lmsg->node, "block", XMLNS,
+	    XMLNS_BLOCKING)) != NULL)
+		read_items(server, node, TRUE);
+	else if ((node = lm_find_node(lmsg->node, "unblock", XMLNS,
+	    XMLNS_BLOCKING)) != NULL) {
+		/* an empty unblock clears the blocklist */
+		if (node->children == NULL)
+			block_clear(server, BLOCKED_SERVER);
+		else
+			read_items(server, node, FALSE);
+	} else
+		return;
+	send_result(server, id);
+}
+
+static void
+sig_server_features(XMPP_SERVER_REC *server)
+{
+	if (!disco_have_feature(server->server_features, XMLNS_BLOCKING)
+	    || g_slist_find(supported_servers, server) != NULL)
+		return;
+	supported_servers = g_slist_prepend(supported_servers, server);
+	request_blocklist(server);
+}
+
+static void
+sig_connected(XMPP_SERVER_REC *server)
+{
+	if (IS_XMPP_SERVER(server))
+		read_ignores(server);
+}
+
+static void
+sig_disconnected(XMPP_SERVER_REC *server)
+{
+	if (!IS_XMPP_SERVER(server))
+		return;
+	supported_servers = g_slist_remove(supported_servers, server);
+	if (server->blocked != NULL) {
+		g_hash_table_destroy(server->blocked);
+		server->blocked = NULL;
+	}
+}
+
+static char *
+get_jid(XMPP_SERVER_REC *server, const char *name)
+{
+	char *jid;
+
+	if ((jid = rosters_resolve_name(server, name)) != NULL)
+		return jid;
+	return g_strdup(name);
+}
+
+/* SYNTAX: BLOCK <jid>|<name> */
+static void
+cmd_block(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
+{
+	char *name, *jid;
+	void *free_arg;
+
+	CMD_XMPP_SERVER(server);
+	if (!cmd_get_params(data, &free_arg, 1, &name))
+		return;
+	if (*name == '\0')
+		cmd_param_error(CMDERR_NOT_ENOUGH_PARAMS);
+	jid = get_jid(server, name);
+	/* the server pushes the change back, without the blocking command
+	 * the JID is only blocked for this session */
+	if (g_slist_find(supported_servers, server) != NULL)
+		send_block(server, "block", jid);
+	else
+		block_add(server, jid, BLOCKED_SERVER);
+	g_free(jid);
+	cmd_params_free(free_arg);
+}
+
+/* SYNTAX: UNBLOCK <jid>|<name> */
+static void
+cmd_unblock(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
+{
+	char *name, *jid;
+	void *free_arg;
+
+	CMD_XMPP_SERVER(server);
+	if (!cmd_get_params(data, &free_arg, 1, &name))
+		return;
+	if (*name == '\0')
+		cmd_param_error(CMDERR_NOT_ENOUGH_PARAMS);
+	jid = get_jid(server, name);
+	if (g_slist_find(supported_servers, server) != NULL)
+		send_block(server, "unblock", jid);
+	else
+		block_remove(server, jid, BLOCKED_SERVER);
+	g_free(jid);
+	cmd_params_free(free_arg);
+}
+
+void
+blocking_init(void)
+{
+	supported_servers = NULL;
+	signal_add("xmpp recv iq", sig_recv_iq);
+	signal_add("xmpp server features", sig_server_features);
+	signal_add("server connected", sig_connected);
+	signal_add("server disconnected", sig_disconnected);
+	signal_add("ignore created", sig_ignores_changed);
+	signal_add("ignore changed", sig_ignores_changed);
+	signal_add("ignore destroyed", sig_ignores_changed);
+	command_bind_xmpp("block", NULL, (SIGNAL_FUNC)cmd_block);
+	command_bind_xmpp("unblock", NULL, (SIGNAL_FUNC)cmd_unblock);
+}
+
+void
+blocking_deinit(void)
+{
+	signal_remove("xmpp recv iq", sig_recv_iq);
+	signal_remove("xmpp server features", sig_server_features);
+	signal_remove("server connected", sig_connected);
+	signal_remove("server disconnected", sig_disconnected);
+	signal_remove("ignore created", sig_ignores_changed);
+	signal_remove("ignore changed", sig_ignores_changed);
+	signal_remove("ignore destroyed", sig_ignores_changed);
+	command_unbind("block", (SIGNAL_FUNC)cmd_block);
+	command_unbind("unblock", (SIGNAL_FUNC)cmd_unblock);
+	g_slist_free(supported_servers);
+}
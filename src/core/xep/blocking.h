@@ -0,0 +1,11 @@
+#ifndef __BLOCKING_H
+#define __BLOCKING_H
+
+__BEGIN_DECLS
+gboolean xmpp_blocked(XMPP_SERVER_REC *, const char *);
+
+void blocking_init(void);
+void blocking_deinit(void);
+__END_DECLS
+
+#endif
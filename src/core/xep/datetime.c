@@ -19,19 +19,14 @@
  * XEP-0082: XMPP Date and Time Profiles
  */
 
-#ifdef __linux__
-#define _XOPEN_SOURCE 
-#endif
-
-#include <ctype.h>
-#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-#define FORMAT  "%Y-%m-%dT%T"
-
 #define nitems(_a) (sizeof((_a)) / sizeof((_a)[0]))
 
+#define ISDIGIT(c)	((c) >= '0' && (c) <= '9')
+
+/* RFC 822 zone names, only found in stamps from broken implementations */
 static long
 parse_timezone(const char *tz)
 {
@@ -65,31 +60,104 @@ parse_timezone(const char *tz)
 	};
 	unsigned int i, j;
 
-	if ((*tz == '+' || *tz == '-') && strlen(tz) == 5) {
-		i = atoi(tz);
-		return ((i/100)*60 + i%100) * 60;
-	}
 	for (i = 0; i < nitems(rfc822_timezones); ++i)
 		for (j = 0; rfc822_timezones[i][j] != NULL; ++j)
 			if (strcmp(rfc822_timezones[i][j], tz) == 0)
-				return (i - 12) * 3600;
+				return ((long)i - 12) * 3600;
 	return 0;
 }
 
+static const char *
+parse_digits(const char *s, int n, int *value)
+{
+	int v;
+
+	for (v = 0; n > 0; --n, ++s) {
+		if (!ISDIGIT(*s))
+			return NULL;
+		v = v * 10 + (*s - '0');
+	}
+	*value = v;
+	return s;
+}
+
+static int
+days_in_month(int year, int month)
+{
+	static const int days[] =
+	    { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+	if (month == 2 && year % 4 == 0
+	    && (year % 100 != 0 || year % 400 == 0))
+		return 29;
+	return days[month - 1];
+}
+
+/*
+ * Days between 1970-01-01 and a date of the proleptic Gregorian calendar,
+ * computed directly, without the timezone lookups of mktime().
+ */
+static long
+days_from_civil(int year, int month, int day)
+{
+	long era;
+	int yoe, doy;
+
+	year -= month <= 2;
+	era = (year >= 0 ? year : year - 399) / 400;
+	yoe = year - era * 400;
+	doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	return era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+}
+
+/*
+ * Parses CCYY-MM-DDThh:mm:ss[.sss][TZD] and the CCYYMMDDThh:mm:ss of
+ * XEP-0091, TZD being Z, +hh:mm, -hh:mm or +hhmm. Stamps without TZD are
+ * in UTC. Returns (time_t)-1 on error.
+ */
 time_t
 xep82_datetime(const char *stamp)
 {
-	struct tm tm;
+	const char *s;
 	long offset;
-	char *s;
+	int year, month, day, hour, min, sec, tzh, tzm, dash, sign;
 
-	memset(&tm, 0, sizeof(struct tm));
-	if ((s = strptime(stamp, FORMAT, &tm)) == NULL)
+	if ((s = stamp) == NULL || (s = parse_digits(s, 4, &year)) == NULL)
+		return (time_t)-1;
+	if ((dash = *s == '-'))
+		s++;
+	if ((s = parse_digits(s, 2, &month)) == NULL
+	    || (dash && *s++ != '-')
+	    || (s = parse_digits(s, 2, &day)) == NULL
+	    || *s++ != 'T'
+	    || (s = parse_digits(s, 2, &hour)) == NULL || *s++ != ':'
+	    || (s = parse_digits(s, 2, &min)) == NULL || *s++ != ':'
+	    || (s = parse_digits(s, 2, &sec)) == NULL)
+		return (time_t)-1;
+	if (month < 1 || month > 12 || day < 1
+	    || day > days_in_month(year, month)
+	    || hour > 23 || min > 59 || sec > 60)
 		return (time_t)-1;
 	/* ignore fractional second addendum */
-	if (*s++ == '.')
-		while (isdigit(*s)) s++;
-	tm.tm_isdst = -1;
-	offset = *s != '\0' ? parse_timezone(s) : 0;
-	return mktime(&tm) - offset;
+	if (*s == '.') {
+		if (!ISDIGIT(s[1]))
+			return (time_t)-1;
+		s++;
+		while (ISDIGIT(*s))
+			s++;
+	}
+	if (*s == '+' || *s == '-') {
+		sign = *s++ == '-' ? -1 : 1;
+		if ((s = parse_digits(s, 2, &tzh)) == NULL)
+			return (time_t)-1;
+		if (*s == ':')
+			s++;
+		if ((s = parse_digits(s, 2, &tzm)) == NULL || *s != '\0'
+		    || tzh > 23 || tzm > 59)
+			return (time_t)-1;
+		offset = sign * (tzh * 3600L + tzm * 60L);
+	} else
+		offset = *s != '\0' ? parse_timezone(s) : 0;
+	return (time_t)(days_from_civil(year, month, day) * 86400L
+	    + hour * 3600L + min * 60L + sec - offset);
 }
@@ -20,23 +20,150 @@
  */
 
 #include "module.h"
+#include "settings.h"
 #include "signals.h"
 
 #include "xmpp-servers.h"
 #include "tools.h"
 #include "datetime.h"
+#include "delay.h"
 #include "disco.h"
 #include "muc.h"
 
 #define XMLNS_DELAY	"urn:xmpp:delay"
 #define XMLNS_OLD_DELAY	"jabber:x:delay"
 
+/*
+ * The history sent by a room when it is joined is gathered until the
+ * subject or the first live message is received, then it is emitted in
+ * order in one go. Delayed messages received later are emitted at once.
+ */
+struct delay_msg {
+	time_t	 time;
+	guint	 seq;
+	gboolean action;
+	char	*nick;
+	char	*msg;
+};
+
+struct delay_batch {
+	MUC_REC	*channel;
+	GSList	*msgs;
+	guint	 seq;
+	int	 timeout_tag;
+};
+
+static GSList *batches;
+
+static struct delay_batch *
+find_batch(MUC_REC *channel)
+{
+	GSList *tmp;
+
+	for (tmp = batches; tmp != NULL; tmp = tmp->next)
+		if (((struct delay_batch *)tmp->data)->channel == channel)
+			return tmp->data;
+	return NULL;
+}
+
+static int
+func_sort_delay(gconstpointer delay1_pointer, gconstpointer delay2_pointer)
+{
+	const struct delay_msg *delay1, *delay2;
+
+	delay1 = delay1_pointer;
+	delay2 = delay2_pointer;
+	if (delay1->time != delay2->time)
+		return delay1->time < delay2->time ? -1 : 1;
+	return delay1->seq < delay2->seq ? -1 : delay1->seq > delay2->seq;
+}
+
+static void
+free_delay(struct delay_msg *delay)
+{
+	g_free(delay->nick);
+	g_free(delay->msg);
+	g_free(delay);
+}
+
+static void
+free_batch(struct delay_batch *batch)
+{
+	batches = g_slist_remove(batches, batch);
+	if (batch->timeout_tag != -1)
+		g_source_remove(batch->timeout_tag);
+	g_slist_foreach(batch->msgs, (GFunc)free_delay, NULL);
+	g_slist_free(batch->msgs);
+	g_free(batch);
+}
+
+static void
+flush_batch(struct delay_batch *batch)
+{
+	XMPP_SERVER_REC *server;
+	struct delay_msg *delay;
+	GSList *tmp;
+	char *target;
+
+	/* the channel may be destroyed by the front end, don't let
+	 * sig_channel_destroyed() find the batch */
+	batches = g_slist_remove(batches, batch);
+	server = batch->channel->server;
+	target = g_strdup(batch->channel->name);
+	batch->msgs = g_slist_sort(batch->msgs, func_sort_delay);
+	for (tmp = batch->msgs; tmp != NULL; tmp = tmp->next) {
+		delay = tmp->data;
+		signal_emit(delay->action ? "message xmpp delay action" :
+		    "message xmpp delay", 6, server, delay->msg, delay->nick,
+		    target, &delay->time,
+		    GINT_TO_POINTER(SEND_TARGET_CHANNEL));
+	}
+	g_free(target);
+	free_batch(batch);
+}
+
+static int
+batch_timeout(struct delay_batch *batch)
+{
+	batch->timeout_tag = -1;
+	flush_batch(batch);
+	return FALSE;
+}
+
+static void
+start_timeout(struct delay_batch *batch)
+{
+	/* some rooms have no subject, don't wait forever */
+	if (batch->timeout_tag != -1)
+		g_source_remove(batch->timeout_tag);
+	batch->timeout_tag = g_timeout_add(
+	    settings_get_time("xmpp_history_batch_time"),
+	    (GSourceFunc)batch_timeout, batch);
+}
+
+static void
+add_delay(struct delay_batch *batch, char *nick, char *msg, gboolean action,
+    time_t t)
+{
+	struct delay_msg *delay;
+
+	delay = g_new(struct delay_msg, 1);
+	delay->time = t;
+	delay->seq = batch->seq++;
+	delay->action = action;
+	delay->nick = nick;
+	delay->msg = msg;
+	batch->msgs = g_slist_prepend(batch->msgs, delay);
+	start_timeout(batch);
+}
+
 static void
 sig_recv_message(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
     const char *id, const char *from, const char *to)
 {
 	LmMessageNode *node;
 	MUC_REC *channel;
+	struct delay_batch *batch;
 	const char *stamp;
 	char *nick, *str;
 	time_t t;
@@ -46,18 +173,28 @@ sig_recv_message(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
 		/* XEP-0091: Delayed Delivery (deprecated) */
 		node = lm_find_node(lmsg->node, "x", "xmlns", XMLNS_OLD_DELAY);
 		if (node == NULL)
-			return;
+			goto flush;
 	}
 	stamp = lm_message_node_get_attribute(node, "stamp");
 	if ((t = xep82_datetime(stamp)) == (time_t)-1)
-		return;
+		goto flush;
 	node = lm_message_node_get_child(lmsg->node, "body");
 	if (node == NULL || node->value == NULL || *node->value == '\0')
-		return;
+		goto flush;
 	if (type == LM_MESSAGE_SUB_TYPE_GROUPCHAT
 	    && (channel = get_muc(server, from)) != NULL
 	    && (nick = muc_extract_nick(from)) != NULL) {
 		str = xmpp_recode_in(node->value);
+		if ((batch = find_batch(channel)) != NULL) {
+			if (g_ascii_strncasecmp(str, "/me ", 4) == 0) {
+				add_delay(batch, nick, g_strdup(str+4), TRUE,
+				    t);
+				g_free(str);
+			} else
+				add_delay(batch, nick, str, FALSE, t);
+			signal_stop();
+			return;
+		}
 		if (g_ascii_strncasecmp(str, "/me ", 4) == 0)
 			 signal_emit("message xmpp delay action", 6,
 			     server, str+4, nick, channel->name, &t,
@@ -85,17 +222,59 @@ sig_recv_message(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
 	} else
 		return;
 	signal_stop();
+	return;
+
+flush:
+	/* the history of the room is complete */
+	if (batches != NULL && type == LM_MESSAGE_SUB_TYPE_GROUPCHAT
+	    && (channel = get_muc(server, from)) != NULL
+	    && (batch = find_batch(channel)) != NULL)
+		flush_batch(batch);
+}
+
+static void
+sig_channel_joined(MUC_REC *channel)
+{
+	struct delay_batch *batch;
+
+	if (!IS_MUC(channel) || find_batch(channel) != NULL
+	    || settings_get_time("xmpp_history_batch_time") <= 0)
+		return;
+	/* the room sends its history right after our own presence */
+	batch = g_new0(struct delay_batch, 1);
+	batch->channel = channel;
+	batch->timeout_tag = -1;
+	batches = g_slist_prepend(batches, batch);
+	start_timeout(batch);
+}
+
+static void
+sig_channel_destroyed(MUC_REC *channel)
+{
+	struct delay_batch *batch;
+
+	if (!IS_MUC(channel))
+		return;
+	if ((batch = find_batch(channel)) != NULL)
+		free_batch(batch);
 }
 
 void
 delay_init(void)
 {
+	settings_add_time("xmpp_lookandfeel", "xmpp_history_batch_time", "2s");
 	disco_add_feature(XMLNS_DELAY);
 	signal_add_first("xmpp recv message", sig_recv_message);
+	signal_add("channel joined", sig_channel_joined);
+	signal_add("channel destroyed", sig_channel_destroyed);
 }
 
 void
 delay_deinit(void)
 {
 	signal_remove("xmpp recv message", sig_recv_message);
+	signal_remove("channel joined", sig_channel_joined);
+	signal_remove("channel destroyed", sig_channel_destroyed);
+	while (batches != NULL)
+		free_batch(batches->data);
 }
@@ -25,6 +25,8 @@
 #include "xmpp-servers.h"
 #include "tools.h"
 #include "disco.h"
+#include "iq.h"
+#include "timeline.h"
 
 #define XMLNS_DISCO "http://jabber.org/protocol/disco#info"
 
@@ -55,6 +57,36 @@ cleanup_features(GSList *list)
 	g_slist_free_full(list, g_free);
 }
 
+static void
+disco_reply(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from, gpointer user_data)
+{
+	LmMessageNode *node;
+	GSList *features;
+
+	if (lmsg == NULL || type != LM_MESSAGE_SUB_TYPE_RESULT)
+		return;
+	node = lm_find_node(lmsg->node, "query", XMLNS, XMLNS_DISCO);
+	if (node == NULL)
+		return;
+	features = NULL;
+	for (node = node->children; node != NULL; node = node->next) {
+		if (strcmp(node->name, "feature") == 0) {
+			features = g_slist_prepend(features,
+			    xmpp_recode_in(
+		    	    lm_message_node_get_attribute(node, "var")));
+		}
+	}
+	signal_emit("xmpp features", 3, server, from, features);
+	if (strcmp(from, server->domain) == 0) {
+		xmpp_timeline_mark(server, "server features");
+		cleanup_features(server->server_features);
+		server->server_features = features;
+		signal_emit("xmpp server features", 1, server);
+	} else
+		cleanup_features(features);
+}
+
 void
 disco_request(XMPP_SERVER_REC *server, const char *dest)
 {
@@ -70,7 +102,7 @@ disco_request(XMPP_SERVER_REC *server, const char *dest)
 	g_free(recoded);
 	node = lm_message_node_add_child(lmsg->node, "query", NULL);
 	lm_message_node_set_attribute(node, XMLNS, XMLNS_DISCO);
-	signal_emit("xmpp send iq", 2, server, lmsg);
+	xmpp_iq_send(server, lmsg, 0, disco_reply, NULL, NULL);
 	lm_message_unref(lmsg);
 }
 
@@ -104,33 +136,9 @@ static void
 sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
     const char *id, const char *from, const char *to)
 {
-	LmMessageNode *node;
-	GSList *features;
-
-	if (type == LM_MESSAGE_SUB_TYPE_RESULT) {
-		node = lm_find_node(lmsg->node, "query", XMLNS, XMLNS_DISCO);
-		if (node == NULL)
-			return;
-		features = NULL;
-		for (node = node->children; node != NULL; node = node->next) {
-			if (strcmp(node->name, "feature") == 0) {
-				features = g_slist_prepend(features,
-				    xmpp_recode_in(
-			    	    lm_message_node_get_attribute(node, "var")));
-			}
-		}
-		signal_emit("xmpp features", 3, server, from, features);
-		if (strcmp(from, server->domain) == 0) {
-			cleanup_features(server->server_features);
-			server->server_features = features;
-			signal_emit("xmpp server features", 1, server);
-		} else
-			cleanup_features(features);
-	} else if (type == LM_MESSAGE_SUB_TYPE_GET) {
-		node = lm_find_node(lmsg->node, "query", XMLNS, XMLNS_DISCO);
-		if (node != NULL)
-			send_disco(server, from);
-	}
+	if (type == LM_MESSAGE_SUB_TYPE_GET
+	    && lm_find_node(lmsg->node, "query", XMLNS, XMLNS_DISCO) != NULL)
+		send_disco(server, from);
 }
 
 static void
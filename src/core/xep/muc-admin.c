@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/*
+ * XEP-0045: Multi-User Chat, affiliation and role lists
+ *
+ * The lists are requested a page at a time with XEP-0059: Result Set
+ * Management, services without it ignore the set and send the whole list
+ * at once. Either way, the items are emitted a chunk at a time when idle,
+ * so a room with thousands of outcasts doesn't freeze the client.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "module.h"
+#include "signals.h"
+
+#include "iq.h"
+#include "keywords.h"
+#include "tools.h"
+#include "muc.h"
+#include "muc-admin.h"
+#include "muc-affiliation.h"
+#include "muc-role.h"
+
+#define XMLNS_RSM "http://jabber.org/protocol/rsm"
+
+#define MUC_ADMIN_PAGE	100	/* items requested at once */
+#define MUC_ADMIN_CHUNK	25	/* items emitted per idle call */
+
+struct admin_item {
+	char	*jid;
+	char	*nick;
+	int	 affiliation;
+	int	 role;		/* -1 in affiliation lists */
+};
+
+struct admin_list {
+	MUC_REC	*channel;
+	char	*attr;		/* "affiliation" or "role" */
+	char	*type;
+	char	*id;		/* of the pending request, if any */
+	char	*last;		/* RSM: last item of the previous page */
+	GSList	*items;
+	int	 count;
+	int	 tag;
+};
+
+static GSList *lists;
+
+static void
+free_item(struct admin_item *item)
+{
+	g_free(item->jid);
+	g_free(item->nick);
+	g_free(item);
+}
+
+static void
+free_list(struct admin_list *list)
+{
+	lists = g_slist_remove(lists, list);
+	if (list->id != NULL) {
+		xmpp_iq_cancel(list->channel->server, list->id);
+		g_free(list->id);
+	}
+	if (list->tag != -1)
+		g_source_remove(list->tag);
+	g_slist_foreach(list->items, (GFunc)free_item, NULL);
+	g_slist_free(list->items);
+	g_free(list->attr);
+	g_free(list->type);
+	g_free(list->last);
+	g_free(list);
+}
+
+static void
+end_list(struct admin_list *list)
+{
+	signal_emit("xmpp muc list end", 3, list->channel, list->type,
+	    GINT_TO_POINTER(list->count));
+	free_list(list);
+}
+
+static void request_page(struct admin_list *);
+
+static int
+output_func(struct admin_list *list)
+{
+	struct admin_item *item;
+	int count;
+
+	for (count = 0; list->items != NULL && count < MUC_ADMIN_CHUNK;
+	    ++count) {
+		item = list->items->data;
+		list->items = g_slist_delete_link(list->items, list->items);
+		if (item->role == -1)
+			signal_emit("message xmpp muc affiliation", 4,
+			    list->channel, item->jid, item->nick,
+			    item->affiliation);
+		else
+			signal_emit("message xmpp muc mode", 4,
+			    list->channel, item->nick, item->affiliation,
+			    item->role);
+		free_item(item);
+		list->count++;
+	}
+	if (list->items != NULL)
+		return TRUE;
+	list->tag = -1;
+	/* the next page is requested once this one is shown */
+	if (list->last != NULL)
+		request_page(list);
+	else
+		end_list(list);
+	return FALSE;
+}
+
+static struct admin_item *
+new_item(LmMessageNode *node)
+{
+	struct admin_item *item;
+	const char *role;
+
+	/* <item affiliation='item_affiliation'
+	 *     role='item_role'
+	 *     jid='item_jid'
+	 *     nick='item_nick'/> */
+	item = g_new0(struct admin_item, 1);
+	item->jid = xmpp_recode_in(lm_message_node_get_attribute(node,
+	    "jid"));
+	item->nick = xmpp_recode_in(lm_message_node_get_attribute(node,
+	    "nick"));
+	item->affiliation = xmpp_nicklist_get_affiliation(
+	    lm_message_node_get_attribute(node, "affiliation"));
+	role = lm_message_node_get_attribute(node, "role");
+	item->role = role != NULL ? xmpp_nicklist_get_role(role) : -1;
+	return item;
+}
+
+static void
+page_reply(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from, gpointer user_data)
+{
+	struct admin_list *list;
+	LmMessageNode *query, *set, *node;
+	GSList *page;
+	const char *last, *condition;
+
+	list = user_data;
+	g_free(list->id);
+	list->id = NULL;
+	if (lmsg == NULL || type != LM_MESSAGE_SUB_TYPE_RESULT) {
+		/* the items of the previous pages were shown already */
+		node = lmsg != NULL ?
+		    lm_message_node_get_child(lmsg->node, "error") : NULL;
+		condition = node != NULL ?
+		    xmpp_get_error_condition(node) : NULL;
+		signal_emit("xmpp muc list error", 3, list->channel,
+		    list->type, lmsg == NULL ? "no reply" :
+		    condition != NULL ? condition : "error");
+		free_list(list);
+		return;
+	}
+	if ((query = lm_find_node(lmsg->node, "query", XMLNS,
+	    XMLNS_MUC_ADMIN)) == NULL) {
+		end_list(list);
+		return;
+	}
+	page = NULL;
+	for (node = query->children; node != NULL; node = node->next)
+		if (strcmp(node->name, "item") == 0)
+			page = g_slist_prepend(page, new_item(node));
+	/* <set xmlns='http://jabber.org/protocol/rsm'>
+	 *   <last>last</last>
+	 *   <count>count</count>
+	 * </set> */
+	set = lm_find_node(query, "set", XMLNS, XMLNS_RSM);
+	node = set != NULL ? lm_message_node_get_child(set, "last") : NULL;
+	last = node != NULL ? node->value : NULL;
+	/* a service ignoring <after/> sends the same page again */
+	if (last != NULL && list->last != NULL
+	    && strcmp(last, list->last) == 0) {
+		g_slist_foreach(page, (GFunc)free_item, NULL);
+		g_slist_free(page);
+		page = NULL;
+	}
+	g_free(list->last);
+	list->last = page != NULL && last != NULL ? g_strdup(last) : NULL;
+	list->items = g_slist_concat(list->items, g_slist_reverse(page));
+	if (output_func(list))
+		list->tag = g_idle_add((GSourceFunc)output_func, list);
+}
+
+static void
+request_page(struct admin_list *list)
+{
+	LmMessage *lmsg;
+	LmMessageNode *query, *item, *set;
+	char *recoded, *str;
+
+	lmsg = lm_message_new_with_sub_type(list->channel->name,
+	    LM_MESSAGE_TYPE_IQ, LM_MESSAGE_SUB_TYPE_GET);
+	recoded = xmpp_recode_out(list->channel->server->jid);
+	lm_message_node_set_attribute(lmsg->node, "from", recoded);
+	g_free(recoded);
+	query = lm_message_node_add_child(lmsg->node, "query", NULL);
+	lm_message_node_set_attribute(query, XMLNS, XMLNS_MUC_ADMIN);
+	item = lm_message_node_add_child(query, "item", NULL);
+	recoded = xmpp_recode_out(list->type);
+	lm_message_node_set_attribute(item, list->attr, recoded);
+	g_free(recoded);
+	set = lm_message_node_add_child(query, "set", NULL);
+	lm_message_node_set_attribute(set, XMLNS, XMLNS_RSM);
+	str = g_strdup_printf("%d", MUC_ADMIN_PAGE);
+	lm_message_node_add_child(set, "max", str);
+	g_free(str);
+	if (list->last != NULL)
+		lm_message_node_add_child(set, "after", list->last);
+	xmpp_iq_send(list->channel->server, lmsg, 0, page_reply, list, NULL);
+	list->id = g_strdup(lm_message_node_get_attribute(lmsg->node, "id"));
+	lm_message_unref(lmsg);
+}
+
+void
+muc_admin_list(MUC_REC *channel, const char *attr, const char *type)
+{
+	struct admin_list *list;
+
+	g_return_if_fail(IS_MUC(channel));
+	g_return_if_fail(attr != NULL);
+	g_return_if_fail(type != NULL);
+	if (!channel->server->connected)
+		return;
+	list = g_new0(struct admin_list, 1);
+	list->channel = channel;
+	list->attr = g_strdup(attr);
+	list->type = g_strdup(type);
+	list->tag = -1;
+	lists = g_slist_prepend(lists, list);
+	request_page(list);
+}
+
+static void
+sig_channel_destroyed(MUC_REC *channel)
+{
+	GSList *tmp, *next;
+
+	if (!IS_MUC(channel))
+		return;
+	for (tmp = lists; tmp != NULL; tmp = next) {
+		next = tmp->next;
+		if (((struct admin_list *)tmp->data)->channel == channel)
+			free_list(tmp->data);
+	}
+}
+
+void
+muc_admin_init(void)
+{
+	lists = NULL;
+	signal_add("channel destroyed", sig_channel_destroyed);
+}
+
+void
+muc_admin_deinit(void)
+{
+	signal_remove("channel destroyed", sig_channel_destroyed);
+	while (lists != NULL)
+		free_list(lists->data);
+}
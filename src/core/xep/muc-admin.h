@@ -0,0 +1,11 @@
+#ifndef __MUC_ADMIN_H
+#define __MUC_ADMIN_H
+
+__BEGIN_DECLS
+void muc_admin_list(MUC_REC *, const char *, const char *);
+
+void muc_admin_init(void);
+void muc_admin_deinit(void);
+__END_DECLS
+
+#endif
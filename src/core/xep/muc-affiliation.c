@@ -19,6 +19,7 @@
 
 #include "module.h"
 
+#include "keywords.h"
 #include "muc-affiliation.h"
 
 const char *xmpp_affiliation[] = {
@@ -33,19 +34,6 @@ const char *xmpp_affiliation[] = {
 int
 xmpp_nicklist_get_affiliation(const char *affiliation)
 {
-	if (affiliation != NULL) {
-		if (g_ascii_strcasecmp(affiliation,
-		    xmpp_affiliation[XMPP_AFFILIATION_OWNER]) == 0)
-			return XMPP_AFFILIATION_OWNER;
-		else if (g_ascii_strcasecmp(affiliation,
-		    xmpp_affiliation[XMPP_AFFILIATION_ADMIN]) == 0)
-			return XMPP_AFFILIATION_ADMIN;
-		else if (g_ascii_strcasecmp(affiliation,
-		    xmpp_affiliation[XMPP_AFFILIATION_MEMBER]) == 0)
-			return XMPP_AFFILIATION_MEMBER;
-		else if (g_ascii_strcasecmp(affiliation,
-		    xmpp_affiliation[XMPP_AFFILIATION_OUTCAST]) == 0)
-			return XMPP_AFFILIATION_OUTCAST;
-	}
-	return XMPP_AFFILIATION_NONE;
+	return xmpp_keyword(XMPP_KEYWORDS_AFFILIATION, affiliation,
+	    XMPP_AFFILIATION_NONE);
 }
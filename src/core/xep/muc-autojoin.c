@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * Rooms joined automatically on connection: a few at a time, the ones
+ * with the highest priority first
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "module.h"
+#include "commands.h"
+#include "lib-config/iconfig.h"
+#include "settings.h"
+#include "signals.h"
+
+#include "jids.h"
+#include "muc.h"
+#include "muc-autojoin.h"
+
+struct autojoin_room {
+	char	*data;
+	char	*name;
+	int	 priority;
+};
+
+struct autojoin_join {
+	struct autojoin	*autojoin;
+	char		*name;
+	int		 timeout_tag;
+};
+
+struct autojoin {
+	XMPP_SERVER_REC	*server;
+	GSList		*queue;
+	GSList		*joining;
+};
+
+static GSList *autojoins;
+
+static struct autojoin *
+find_autojoin(XMPP_SERVER_REC *server)
+{
+	GSList *tmp;
+
+	for (tmp = autojoins; tmp != NULL; tmp = tmp->next)
+		if (((struct autojoin *)tmp->data)->server == server)
+			return tmp->data;
+	return NULL;
+}
+
+static void
+free_room(struct autojoin_room *room)
+{
+	g_free(room->data);
+	g_free(room->name);
+	g_free(room);
+}
+
+static void
+free_join(struct autojoin_join *join)
+{
+	if (join->timeout_tag != 0)
+		g_source_remove(join->timeout_tag);
+	g_free(join->name);
+	g_free(join);
+}
+
+static void
+autojoin_destroy(struct autojoin *aj)
+{
+	autojoins = g_slist_remove(autojoins, aj);
+	g_slist_free_full(aj->queue, (GDestroyNotify)free_room);
+	g_slist_free_full(aj->joining, (GDestroyNotify)free_join);
+	g_free(aj);
+}
+
+/* never 0, so the rooms of the same priority keep their order */
+static gint
+func_sort_room(struct autojoin_room *room1, struct autojoin_room *room2)
+{
+	return room2->priority >= room1->priority ? 1 : -1;
+}
+
+static gboolean
+is_queued(struct autojoin *aj, const char *name)
+{
+	GSList *tmp;
+
+	for (tmp = aj->queue; tmp != NULL; tmp = tmp->next)
+		if (strcmp(((struct autojoin_room *)tmp->data)->name, name) == 0)
+			return TRUE;
+	for (tmp = aj->joining; tmp != NULL; tmp = tmp->next)
+		if (strcmp(((struct autojoin_join *)tmp->data)->name, name) == 0)
+			return TRUE;
+	return FALSE;
+}
+
+/* Queues a room, with the same data as muc_join() */
+void
+muc_autojoin_add(XMPP_SERVER_REC *server, const char *data, int priority)
+{
+	struct autojoin *aj;
+	struct autojoin_room *room;
+	char *chanline, *channame;
+	void *free_arg;
+
+	g_return_if_fail(IS_XMPP_SERVER(server));
+	g_return_if_fail(data != NULL);
+	if (!cmd_get_params(data, &free_arg, 1, &chanline))
+		return;
+	channame = muc_extract_channel(chanline);
+	cmd_params_free(free_arg);
+	if ((aj = find_autojoin(server)) == NULL) {
+		aj = g_new0(struct autojoin, 1);
+		aj->server = server;
+		autojoins = g_slist_prepend(autojoins, aj);
+	}
+	if (muc_find(server, channame) != NULL
+	    || is_queued(aj, xmpp_jid_canonical(channame))) {
+		g_free(channame);
+		return;
+	}
+	room = g_new0(struct autojoin_room, 1);
+	room->data = g_strdup(data);
+	room->name = g_strdup(xmpp_jid_canonical(channame));
+	room->priority = priority;
+	g_free(channame);
+	aj->queue = g_slist_insert_sorted(aj->queue, room,
+	    (GCompareFunc)func_sort_room);
+}
+
+static void join_done(struct autojoin *, const char *);
+
+static gboolean
+join_timeout(struct autojoin_join *join)
+{
+	/* stop waiting for it, the room stays */
+	join->timeout_tag = 0;
+	join_done(join->autojoin, join->name);
+	return FALSE;
+}
+
+static void
+run_queue(struct autojoin *aj)
+{
+	struct autojoin_room *room;
+	struct autojoin_join *join;
+	MUC_REC *channel;
+	int max, timeout;
+
+	max = settings_get_int("xmpp_autojoin_max_inflight");
+	timeout = settings_get_time("xmpp_autojoin_timeout");
+	while (aj->queue != NULL
+	    && (max <= 0 || g_slist_length(aj->joining) < (guint)max)) {
+		room = aj->queue->data;
+		aj->queue = g_slist_delete_link(aj->queue, aj->queue);
+		channel = muc_find(aj->server, room->name) == NULL ?
+		    muc_join(aj->server, room->data, TRUE) : NULL;
+		if (channel != NULL && !channel->joined) {
+			join = g_new0(struct autojoin_join, 1);
+			join->autojoin = aj;
+			join->name = g_strdup(
+			    xmpp_jid_canonical(channel->name));
+			if (timeout > 0)
+				join->timeout_tag = g_timeout_add(timeout,
+				    (GSourceFunc)join_timeout, join);
+			aj->joining = g_slist_append(aj->joining, join);
+		}
+		free_room(room);
+	}
+	if (aj->queue == NULL && aj->joining == NULL)
+		autojoin_destroy(aj);
+}
+
+static void
+join_done(struct autojoin *aj, const char *name)
+{
+	GSList *tmp;
+	struct autojoin_join *join;
+
+	for (tmp = aj->joining; tmp != NULL; tmp = tmp->next) {
+		join = tmp->data;
+		if (strcmp(join->name, name) == 0) {
+			aj->joining = g_slist_delete_link(aj->joining, tmp);
+			free_join(join);
+			run_queue(aj);
+			return;
+		}
+	}
+}
+
+/* Starts joining the queued rooms */
+void
+muc_autojoin_start(XMPP_SERVER_REC *server)
+{
+	struct autojoin *aj;
+
+	g_return_if_fail(IS_XMPP_SERVER(server));
+	if ((aj = find_autojoin(server)) != NULL)
+		run_queue(aj);
+}
+
+static void
+sig_channel_joined(MUC_REC *channel)
+{
+	struct autojoin *aj;
+
+	if (IS_MUC(channel)
+	    && (aj = find_autojoin(channel->server)) != NULL)
+		join_done(aj, xmpp_jid_canonical(channel->name));
+}
+
+static void
+sig_disconnected(XMPP_SERVER_REC *server)
+{
+	struct autojoin *aj;
+
+	if (IS_XMPP_SERVER(server) && (aj = find_autojoin(server)) != NULL)
+		autojoin_destroy(aj);
+}
+
+static void
+sig_setup_created(CHANNEL_SETUP_REC *setup, CONFIG_NODE *node)
+{
+	MUC_SETUP_REC *muc_setup;
+
+	if ((muc_setup = MUC_SETUP(setup)) != NULL)
+		muc_setup->priority = config_node_get_int(node, "priority", 0);
+}
+
+static void
+sig_setup_saved(CHANNEL_SETUP_REC *setup, CONFIG_NODE *node)
+{
+	MUC_SETUP_REC *muc_setup;
+
+	if ((muc_setup = MUC_SETUP(setup)) != NULL
+	    && muc_setup->priority != 0)
+		iconfig_node_set_int(node, "priority", muc_setup->priority);
+}
+
+static void
+sig_channel_add_fill(CHANNEL_SETUP_REC *setup, GHashTable *optlist)
+{
+	MUC_SETUP_REC *muc_setup;
+	char *value;
+
+	if ((muc_setup = MUC_SETUP(setup)) != NULL
+	    && (value = g_hash_table_lookup(optlist, "priority")) != NULL)
+		muc_setup->priority = atoi(value);
+}
+
+void
+muc_autojoin_init(void)
+{
+	autojoins = NULL;
+	settings_add_int("xmpp", "xmpp_autojoin_max_inflight", 4);
+	settings_add_time("xmpp", "xmpp_autojoin_timeout", "30s");
+	command_set_options("channel add", "-priority");
+	signal_add("channel joined", sig_channel_joined);
+	signal_add("channel destroyed", sig_channel_joined);
+	signal_add_first("server disconnected", sig_disconnected);
+	signal_add("channel setup created", sig_setup_created);
+	signal_add("channel setup saved", sig_setup_saved);
+	signal_add("channel add fill", sig_channel_add_fill);
+}
+
+void
+muc_autojoin_deinit(void)
+{
+	signal_remove("channel joined", sig_channel_joined);
+	signal_remove("channel destroyed", sig_channel_joined);
+	signal_remove("server disconnected", sig_disconnected);
+	signal_remove("channel setup created", sig_setup_created);
+	signal_remove("channel setup saved", sig_setup_saved);
+	signal_remove("channel add fill", sig_channel_add_fill);
+	while (autojoins != NULL)
+		autojoin_destroy(autojoins->data);
+}
@@ -0,0 +1,12 @@
+#ifndef __MUC_AUTOJOIN_H
+#define __MUC_AUTOJOIN_H
+
+__BEGIN_DECLS
+void muc_autojoin_add(XMPP_SERVER_REC *, const char *, int);
+void muc_autojoin_start(XMPP_SERVER_REC *);
+
+void muc_autojoin_init(void);
+void muc_autojoin_deinit(void);
+__END_DECLS
+
+#endif
@@ -27,6 +27,7 @@
 #include "tools.h"
 #include "rosters-tools.h"
 #include "muc.h"
+#include "muc-nicklist.h"
 #include "disco.h"
 
 /* SYNTAX: INVITE <jid>[/<resource>]|<name> [<channame>] */
@@ -150,7 +151,18 @@ cmd_topic(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 	cmd_params_free(free_arg);
 }
 
-/* SYNTAX: AFFILIATION [<channel>] <type> [<jid>] [<reason>] */
+/* the real JID of an occupant of a non-anonymous room */
+static const char *
+get_real_jid(MUC_REC *channel, const char *nickname)
+{
+	XMPP_NICK_REC *nick;
+
+	nick = xmpp_nicklist_find(channel, nickname);
+	return nick != NULL && nick->real_jid != NULL ?
+	    nick->real_jid : nickname;
+}
+
+/* SYNTAX: AFFILIATION [<channel>] <type> [<jid>|<nick>] [<reason>] */
 static void
 cmd_affiliation(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 {
@@ -171,12 +183,13 @@ cmd_affiliation(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 	} else {
 		if (*reason == '\0')
 			reason = NULL;
-		muc_set_affiliation(server, channel, type, jid, reason);
+		muc_set_affiliation(server, channel, type,
+		    get_real_jid(channel, jid), reason);
 	}
 	cmd_params_free(free_arg);
 }
 
-/* SYNTAX: BAN [<channel>] <jid> [<reason>] */
+/* SYNTAX: BAN [<channel>] <jid>|<nick> [<reason>] */
 static void
 cmd_ban(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 {
@@ -195,7 +208,8 @@ cmd_ban(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 	if (*reason == '\0')
 		reason = NULL;
 
-	muc_set_affiliation(server, channel, "outcast", jid, reason);
+	muc_set_affiliation(server, channel, "outcast",
+	    get_real_jid(channel, jid), reason);
 	cmd_params_free(free_arg);
 }
 
@@ -225,11 +239,12 @@ cmd_role(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 	cmd_params_free(free_arg);
 }
 
-/* SYNTAX: kick [<channel>] <nick> [<reason>] */
+/* SYNTAX: kick [<channel>] <nick>|<jid> [<reason>] */
 static void
 cmd_kick(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 {
 	MUC_REC *channel;
+	GSList *tmp;
 	char *channame, *nick, *reason;
 	void *free_arg;
 
@@ -243,7 +258,14 @@ cmd_kick(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 		cmd_param_error(CMDERR_NOT_JOINED);
 	if (*reason == '\0')
 		reason = NULL;
-	muc_set_role(server, channel, "none", nick, reason);
+	/* a real JID kicks all its occupants */
+	if (xmpp_nicklist_find(channel, nick) == NULL
+	    && (tmp = xmpp_nicklist_find_real_jid(channel, nick)) != NULL) {
+		for (; tmp != NULL; tmp = tmp->next)
+			muc_set_role(server, channel, "none",
+			    NICK(tmp->data)->nick, reason);
+	} else
+		muc_set_role(server, channel, "none", nick, reason);
 	cmd_params_free(free_arg);
 }
 
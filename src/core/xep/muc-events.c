@@ -28,6 +28,7 @@
 #include "settings.h"
 #include "signals.h"
 
+#include "keywords.h"
 #include "rosters-tools.h"
 #include "tools.h"
 #include "disco.h"
@@ -156,8 +157,10 @@ own_event(MUC_REC *channel, const char *nickname, const char *full_jid,
 	if ((nick = xmpp_nicklist_find(channel, nickname)) == NULL)
 		own_join(channel, nickname, full_jid, affiliation, role,
 		    forced);
-	else
+	else {
+		xmpp_nicklist_set_real_jid(channel, nick, full_jid);
 		nick_mode(channel, nick, affiliation, role);
+	}
 }
 
 static void
@@ -168,8 +171,10 @@ nick_event(MUC_REC *channel, const char *nickname, const char *full_jid,
 
 	if ((nick = xmpp_nicklist_find(channel, nickname)) == NULL)
 		nick_join(channel, nickname, full_jid, affiliation, role);
-	else
+	else {
+		xmpp_nicklist_set_real_jid(channel, nick, full_jid);
 		nick_mode(channel, nick, affiliation, role);
+	}
 }
 
 static void
@@ -226,11 +231,8 @@ nick_kicked(MUC_REC *channel, const char *nickname, const char *actor,
 }
 
 static void
-error_message(MUC_REC *channel, const char *code)
+error_message(MUC_REC *channel, int error)
 {
-	int error;
-
-	error = code != NULL ? atoi(code) : MUC_ERROR_UNKNOWN;
 	switch (error) {
 	case MUC_ERROR_PASSWORD_INVALID_OR_MISSING:
 		signal_emit("xmpp muc error", 2, channel, "not allowed");
@@ -239,14 +241,12 @@ error_message(MUC_REC *channel, const char *code)
 }
 
 static void
-error_join(MUC_REC *channel, const char *code, const char *nick)
+error_join(MUC_REC *channel, int error, const char *nick)
 {
 	char *altnick;
-	int error;
 
 	if (nick != NULL && strcmp(nick, channel->nick) != 0)
 		return;
-	error = code != NULL ? atoi(code) : MUC_ERROR_UNKNOWN;
 	signal_emit("xmpp muc joinerror", 2, channel, GINT_TO_POINTER(error));
 	switch(error) {
 	case MUC_ERROR_USE_RESERVED_ROOM_NICK:
@@ -269,11 +269,8 @@ error_join(MUC_REC *channel, const char *code, const char *nick)
 }
 
 static void
-error_presence(MUC_REC *channel, const char *code, const char *nick)
+error_presence(MUC_REC *channel, int error, const char *nick)
 {
-	int error;
-
-	error = code != NULL ? atoi(code) : MUC_ERROR_UNKNOWN;
 	switch (error) {
 	case MUC_ERROR_NICK_IN_USE:
 		signal_emit("message xmpp muc nick in use", 2, channel, nick);
@@ -282,11 +279,8 @@ error_presence(MUC_REC *channel, const char *code, const char *nick)
 }
 
 static void
-error_destroy(MUC_REC *channel, const char *code, const char *reason)
+error_destroy(MUC_REC *channel, int error, const char *reason)
 {
-	int error;
-
-	error = code != NULL ? atoi(code) : MUC_ERROR_UNKNOWN;
 	switch (error) {
 	case 403:
 		signal_emit("xmpp muc destroyerror", 2, channel, reason);
@@ -298,22 +292,36 @@ static void
 available(MUC_REC *channel, const char *from, LmMessage *lmsg)
 {
 	LmMessageNode *node;
+	LM_FIND_REC presence[] = {
+		/* <x xmlns='http://jabber.org/protocol/muc#user'> */
+		{ "x", XMLNS, XMLNS_MUC_USER, NULL },
+		/* <status>text</status> */
+		{ "status", NULL, NULL, NULL },
+		/* <show>show</show> */
+		{ "show", NULL, NULL, NULL }
+	};
+	LM_FIND_REC muc_user[] = {
+		{ "item", NULL, NULL, NULL },
+		/* <status code='110'/> */
+		{ "status", "code", "110", NULL },
+		/* <status code='210'/> */
+		{ "status", "code", "210", NULL },
+		/* <status code='201'/> */
+		{ "status", "code", "201", NULL }
+	};
 	const char *item_affiliation, *item_role, *nick;
 	char *item_jid, *item_nick, *status;
 	gboolean own, forced, created;
 
 	item_affiliation = item_role = status = NULL;
 	item_jid = item_nick = NULL;
-	/* <x xmlns='http://jabber.org/protocol/muc#user'> */
-	if ((node = lm_find_node(lmsg->node, "x", XMLNS,
-	    XMLNS_MUC_USER)) == NULL)
+	lm_find_nodes(lmsg->node, presence, G_N_ELEMENTS(presence));
+	if (presence[0].node == NULL)
 		return;
-	/* <status code='110'/> */
-	own = lm_find_node(node, "status", "code", "110") != NULL;
-	/* <status code='210'/> */
-	forced = lm_find_node(node, "status", "code", "210") != NULL;
-	/* <status code='201'/> */
-	created = lm_find_node(node, "status", "code", "201") != NULL;
+	lm_find_nodes(presence[0].node, muc_user, G_N_ELEMENTS(muc_user));
+	own = muc_user[1].node != NULL;
+	forced = muc_user[2].node != NULL;
+	created = muc_user[3].node != NULL;
 	if (created) {
 		char str[MAX_LONG_STRLEN], *data, *recoded;
 		LmMessage *lmsg;
@@ -339,7 +347,7 @@ available(MUC_REC *channel, const char *from, LmMessage *lmsg)
 		signal_emit("event 329", 2, channel->server, data);
 		g_free(data);
 	}
-	if ((node = lm_message_node_get_child(node, "item")) == NULL)
+	if ((node = muc_user[0].node) == NULL)
 		return;
 	/* <item affiliation='item_affiliation'
 	 *     role='item_role'
@@ -357,13 +365,10 @@ available(MUC_REC *channel, const char *from, LmMessage *lmsg)
 		    forced);
 	else
 		nick_event(channel, nick, item_jid, item_affiliation, item_role);
-	/* <status>text</status> */
-	node = lm_message_node_get_child(lmsg->node, "status");
-	if (node != NULL)
-		status = xmpp_recode_in(node->value);
-	/* <show>show</show> */
-	node = lm_message_node_get_child(lmsg->node, "show");
-	nick_presence(channel, nick, node != NULL ? node->value : NULL, status);
+	if (presence[1].node != NULL)
+		status = xmpp_recode_in(presence[1].node->value);
+	nick_presence(channel, nick, presence[2].node != NULL ?
+	    presence[2].node->value : NULL, status);
 	g_free(status);
 err:	g_free(item_jid);
 	g_free(item_nick);
@@ -427,42 +432,6 @@ unavailable(MUC_REC *channel, const char *nick, LmMessage *lmsg)
 	g_free(actor);
 }
 
-static void
-admin(MUC_REC *channel, LmMessage *lmsg)
-{
-	LmMessageNode *node, *query;
-	const char *item_affiliation, *item_role, *item_jid, *item_nick;
-	int affiliation, role;
-
-	if ((query = lm_find_node(lmsg->node, "query", XMLNS,
-	    XMLNS_MUC_ADMIN)) == NULL)
-		return;
-
-	for (node = query->children; node != NULL; node = node->next) {
-		/* <item affiliation='item_affiliation'
-		 *     role='item_role'
-		 *     jid='item_jid'
-		 *     nick='item_nick'/> */
-		item_jid = xmpp_recode_in(lm_message_node_get_attribute(node,
-		    "jid"));
-		item_affiliation = lm_message_node_get_attribute(node,
-		    "affiliation");
-		item_nick = xmpp_recode_in(lm_message_node_get_attribute(node,
-		    "nick"));
-		item_role = lm_message_node_get_attribute(node, "role");
-		affiliation = xmpp_nicklist_get_affiliation(item_affiliation);
-		if (item_role == NULL) {
-			/* affiliation query */
-			signal_emit("message xmpp muc affiliation", 4, channel,
-			    item_jid, item_nick, affiliation);
-		} else {
-			role = xmpp_nicklist_get_role(item_role);
-			signal_emit("message xmpp muc mode", 4, channel,
-			    item_nick, affiliation, role);
-		}
-	}
-}
-
 static void
 invite(XMPP_SERVER_REC *server, const char *channame, LmMessageNode *node,
     LmMessageNode *invite_node)
@@ -524,11 +493,8 @@ sig_recv_message(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
 	switch (type) {
 	case LM_MESSAGE_SUB_TYPE_ERROR:
 		node = lm_message_node_get_child(lmsg->node, "error");
-		if (node != NULL) {
-			/* TODO: extract error type and name -> XMLNS_STANZAS */
-			error_message(channel,
-			    lm_message_node_get_attribute(node, "code"));
-		}
+		if (node != NULL)
+			error_message(channel, xmpp_get_error_code(node));
 		break;
 	case LM_MESSAGE_SUB_TYPE_GROUPCHAT:
 		node = lm_message_node_get_child(lmsg->node, "subject");
@@ -574,8 +540,8 @@ sig_recv_presence(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
 {
 	MUC_REC *channel;
 	LmMessageNode *node;
-	const char *code;
 	char *nick;
+	int error;
 
 	if ((channel = get_muc(server, from)) == NULL)
 		return;
@@ -585,12 +551,11 @@ sig_recv_presence(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
 		node = lm_message_node_get_child(lmsg->node, "error");
 		if (node == NULL)
 			goto out;
-		/* TODO: extract error type and name -> XMLNS_STANZAS */
-		code = lm_message_node_get_attribute(node, "code");
+		error = xmpp_get_error_code(node);
 		if (!channel->joined)
-			error_join(channel, code, nick);
+			error_join(channel, error, nick);
 		else
-			error_presence(channel, code, nick);
+			error_presence(channel, error, nick);
 		break;
 	case LM_MESSAGE_SUB_TYPE_AVAILABLE:
 		available(channel, nick, lmsg);
@@ -610,8 +575,8 @@ sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
 {
 	MUC_REC *channel;
 	LmMessageNode *node, *error, *text, *query;
-	const char *code;
 	char *reason;
+	int code;
 
 	if ((channel = get_muc(server, from)) == NULL)
 		return;
@@ -621,7 +586,7 @@ sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
 		error = lm_message_node_get_child(lmsg->node, "error");
 		if (error == NULL)
 			return;
-		code = lm_message_node_get_attribute(error, "code");
+		code = xmpp_get_error_code(error);
 
 		query = lm_find_node(lmsg->node, "query", XMLNS, XMLNS_MUC_OWNER);
 		if (query == NULL)
@@ -635,9 +600,6 @@ sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
 			}
 		}
 		break;
-	case LM_MESSAGE_SUB_TYPE_RESULT:
-		admin(channel, lmsg);
-		break;
 	}
 }
 
@@ -20,31 +20,98 @@
 #include "module.h"
 #include "signals.h"
 
+#include "jids.h"
 #include "rosters.h"
+#include "tools.h"
 #include "muc-affiliation.h"
 #include "muc-nicklist.h"
 #include "muc-role.h"
 
+static void
+real_jid_add(MUC_REC *channel, XMPP_NICK_REC *nick)
+{
+	GSList *list;
+
+	if (channel->real_jids == NULL)
+		channel->real_jids = g_hash_table_new_full(g_direct_hash,
+		    g_direct_equal, NULL, (GDestroyNotify)g_slist_free);
+	/* the keys are atoms: compared by address */
+	list = g_hash_table_lookup(channel->real_jids, nick->real_jid);
+	if (list == NULL)
+		g_hash_table_insert(channel->real_jids, nick->real_jid,
+		    g_slist_prepend(NULL, nick));
+	else
+		g_slist_append(list, nick);
+}
+
+static void
+real_jid_remove(MUC_REC *channel, XMPP_NICK_REC *nick)
+{
+	GSList *list;
+
+	if (channel->real_jids == NULL || (list = g_hash_table_lookup(
+	    channel->real_jids, nick->real_jid)) == NULL)
+		return;
+	g_hash_table_steal(channel->real_jids, nick->real_jid);
+	if ((list = g_slist_remove(list, nick)) != NULL)
+		g_hash_table_insert(channel->real_jids, nick->real_jid, list);
+}
+
 XMPP_NICK_REC *
 xmpp_nicklist_insert(MUC_REC *channel, const char *nickname,
     const char *full_jid)
 {
 	XMPP_NICK_REC *rec;
+	char *str;
 
 	g_return_val_if_fail(IS_MUC(channel), NULL);
 	g_return_val_if_fail(nickname != NULL, NULL);
 	rec = g_new0(XMPP_NICK_REC, 1);
 	rec->nick = g_strdup(nickname);
-	rec->host = (full_jid != NULL) ?
-	    g_strdup(full_jid) : g_strconcat(channel->name, "/", rec->nick, (void *)NULL);
+	if (full_jid != NULL) {
+		rec->host = xmpp_jid_ref(full_jid);
+		str = xmpp_strip_resource(full_jid);
+		rec->real_jid = xmpp_jid_ref(str);
+		g_free(str);
+	} else {
+		str = g_strconcat(channel->name, "/", rec->nick, (void *)NULL);
+		rec->host = xmpp_jid_ref(str);
+		g_free(str);
+	}
 	rec->show = XMPP_PRESENCE_AVAILABLE;
 	rec->status = NULL;
 	rec->affiliation = XMPP_AFFILIATION_NONE;
 	rec->role = XMPP_ROLE_NONE;
 	nicklist_insert(CHANNEL(channel), (NICK_REC *)rec);
+	if (rec->real_jid != NULL)
+		real_jid_add(channel, rec);
 	return rec;
 }
 
+/* A later presence may reveal the real JID of an occupant, after a
+ * role change in a semi-anonymous room */
+void
+xmpp_nicklist_set_real_jid(MUC_REC *channel, XMPP_NICK_REC *nick,
+    const char *full_jid)
+{
+	char *str;
+
+	g_return_if_fail(IS_MUC(channel));
+	g_return_if_fail(IS_XMPP_NICK(nick));
+	if (full_jid == NULL || xmpp_jid_lookup(full_jid) == nick->host)
+		return;
+	if (nick->real_jid != NULL) {
+		real_jid_remove(channel, nick);
+		xmpp_jid_unref(nick->real_jid);
+	}
+	xmpp_jid_unref(nick->host);
+	nick->host = xmpp_jid_ref(full_jid);
+	str = xmpp_strip_resource(full_jid);
+	nick->real_jid = xmpp_jid_ref(str);
+	g_free(str);
+	real_jid_add(channel, nick);
+}
+
 static void
 nick_hash_add(CHANNEL_REC *channel, NICK_REC *nick)
 {
@@ -98,7 +165,8 @@ xmpp_nicklist_rename(MUC_REC *channel, XMPP_NICK_REC *nick,
 	nick_hash_remove(CHANNEL(channel), NICK(nick));
 	g_free(nick->nick);
 	nick->nick = g_strdup(newnick);
-	/* add new nick to hash table */
+	/* add new nick to hash table, the real JID index holds the
+	 * record itself and doesn't change */
 	nick_hash_add(CHANNEL(channel), NICK(nick));
 	signal_emit("nicklist changed", 3, channel, nick, oldnick);
 	if (strcmp(oldnick, channel->nick) == 0) {
@@ -160,22 +228,80 @@ xmpp_nicklist_set_presence(XMPP_NICK_REC *nick, int show, const char *status)
 	nick->status = g_strdup(status);
 }
 
+/* Returns the occupants of the room with this real JID, the list
+ * belongs to the room */
+GSList *
+xmpp_nicklist_find_real_jid(MUC_REC *channel, const char *jid)
+{
+	char *atom;
+
+	g_return_val_if_fail(IS_MUC(channel), NULL);
+	g_return_val_if_fail(jid != NULL, NULL);
+	if (channel->real_jids == NULL)
+		return NULL;
+	if ((atom = xmpp_jid_lookup_len(jid, strcspn(jid, "/"))) == NULL)
+		return NULL;
+	return g_hash_table_lookup(channel->real_jids, atom);
+}
+
+/* Returns the rooms this real JID is in */
+GSList *
+xmpp_nicklist_get_rooms(XMPP_SERVER_REC *server, const char *jid)
+{
+	GSList *tmp, *rooms;
+	MUC_REC *channel;
+	char *atom;
+
+	g_return_val_if_fail(IS_XMPP_SERVER(server), NULL);
+	g_return_val_if_fail(jid != NULL, NULL);
+	if ((atom = xmpp_jid_lookup_len(jid, strcspn(jid, "/"))) == NULL)
+		return NULL;
+	rooms = NULL;
+	for (tmp = server->channels; tmp != NULL; tmp = tmp->next) {
+		channel = MUC(tmp->data);
+		if (channel != NULL && channel->real_jids != NULL
+		    && g_hash_table_lookup(channel->real_jids, atom) != NULL)
+			rooms = g_slist_prepend(rooms, channel);
+	}
+	return g_slist_reverse(rooms);
+}
+
 static void
 sig_nicklist_remove(MUC_REC *channel, XMPP_NICK_REC *nick)
 {
 	if (!IS_MUC(channel) || !IS_XMPP_NICK(nick))
 		return;
 	g_free(nick->status);
+	nick->status = NULL;
+	if (nick->real_jid != NULL) {
+		real_jid_remove(channel, nick);
+		xmpp_jid_unref(nick->real_jid);
+		nick->real_jid = NULL;
+	}
+	/* the host is an atom, irssi must not free it */
+	xmpp_jid_unref(nick->host);
+	nick->host = NULL;
+}
+
+static void
+sig_channel_destroyed(MUC_REC *channel)
+{
+	if (!IS_MUC(channel) || channel->real_jids == NULL)
+		return;
+	g_hash_table_destroy(channel->real_jids);
+	channel->real_jids = NULL;
 }
 
 void
 muc_nicklist_init(void)
 {
-	signal_add("nicklist remove", sig_nicklist_remove);
+	signal_add_last("nicklist remove", sig_nicklist_remove);
+	signal_add_last("channel destroyed", sig_channel_destroyed);
 }
 
 void
 muc_nicklist_deinit(void)
 {
 	signal_remove("nicklist remove", sig_nicklist_remove);
+	signal_remove("channel destroyed", sig_channel_destroyed);
 }
@@ -23,16 +23,22 @@ struct _XMPP_NICK_REC {
 
 	int	 affiliation;
 	int 	 role;
+
+	char	*real_jid;	/* bare, NULL in anonymous rooms */
 };
 
 __BEGIN_DECLS
 XMPP_NICK_REC	*xmpp_nicklist_insert(MUC_REC *, const char *, const char *);
 void		 xmpp_nicklist_rename(MUC_REC *, XMPP_NICK_REC *, const char *,
 		     const char *);
+void		 xmpp_nicklist_set_real_jid(MUC_REC *, XMPP_NICK_REC *,
+		     const char *);
 gboolean	 xmpp_nicklist_modes_changed(XMPP_NICK_REC *, int, int);
 void		 xmpp_nicklist_set_modes(XMPP_NICK_REC *, int, int);
 void		 xmpp_nicklist_set_presence(XMPP_NICK_REC *, int,
 		     const char *);
+GSList		*xmpp_nicklist_find_real_jid(MUC_REC *, const char *);
+GSList		*xmpp_nicklist_get_rooms(XMPP_SERVER_REC *, const char *);
 
 void muc_nicklist_init(void);
 void muc_nicklist_deinit(void);
@@ -21,6 +21,7 @@
 
 #include "xmpp-servers.h"
 #include "muc.h"
+#include "muc-autojoin.h"
 
 static void
 sig_conn_copy(SERVER_CONNECT_REC **dest, XMPP_SERVER_CONNECT_REC *src)
@@ -79,15 +80,16 @@ restore_channels(XMPP_SERVER_REC *server)
 {
 	GSList *tmp;
 
-	if (server->connrec->channels_list != NULL)
+	if (server->connrec->channels_list == NULL)
 		return;
 	for (tmp = server->connrec->channels_list; tmp != NULL;
 	    tmp = tmp->next) {
-	    	muc_join(server, tmp->data, TRUE);
+		muc_autojoin_add(server, tmp->data, 0);
 		g_free(tmp->data);
 	}
 	g_slist_free(server->connrec->channels_list);
 	server->connrec->channels_list = NULL;
+	muc_autojoin_start(server);
 }
 
 static void
@@ -17,8 +17,9 @@
 
 #include <string.h>
 
-#include <glib.h>
+#include "module.h"
 
+#include "keywords.h"
 #include "muc-role.h"
 
 const char *xmpp_role[] = {
@@ -32,16 +33,5 @@ const char *xmpp_role[] = {
 int
 xmpp_nicklist_get_role(const char *role)
 {
-	if (role != NULL) {
-		if (g_ascii_strcasecmp(role,
-		    xmpp_role[XMPP_ROLE_MODERATOR]) == 0)
-			return XMPP_ROLE_MODERATOR;
-		else if (g_ascii_strcasecmp(role,
-		    xmpp_role[XMPP_ROLE_PARTICIPANT]) == 0)
-			return XMPP_ROLE_PARTICIPANT;
-		else if (g_ascii_strcasecmp(role,
-		    xmpp_role[XMPP_ROLE_VISITOR]) == 0)
-			return XMPP_ROLE_VISITOR;
-	}
-	return XMPP_ROLE_NONE;
+	return xmpp_keyword(XMPP_KEYWORDS_ROLE, role, XMPP_ROLE_NONE);
 }
@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/*
+ * XEP-0410: MUC Self-Ping
+ *
+ * Every joined room is pinged at our own occupant JID from time to time,
+ * to find out whether the server still considers us in it. The pings of
+ * all the rooms are scheduled on a timer wheel ticking every second, with
+ * some jitter so that the rooms aren't pinged all at once.
+ */
+
+#include <string.h>
+
+#include "module.h"
+#include "settings.h"
+#include "signals.h"
+
+#include "iq.h"
+#include "keywords.h"
+#include "muc.h"
+#include "muc-selfping.h"
+
+#define XMLNS_PING	"urn:xmpp:ping"
+
+#define WHEEL_SLOTS	64
+
+struct selfping {
+	MUC_REC		*channel;
+	int		 slot;
+	int		 rounds;
+	gboolean	 waiting;
+};
+
+struct selfping_request {
+	XMPP_SERVER_REC	*server;
+	char		*name;
+};
+
+static GSList		*wheel[WHEEL_SLOTS];
+static int		 wheel_pos;
+static int		 wheel_tag;
+static GHashTable	*selfpings;
+static int		 interval;
+
+static void
+schedule(struct selfping *sp)
+{
+	int delay;
+
+	if (interval <= 0)
+		return;
+	/* +/- 25% */
+	delay = interval - interval / 4
+	    + g_random_int_range(0, interval / 2 + 1);
+	if (delay < 1)
+		delay = 1;
+	sp->slot = (wheel_pos + delay) % WHEEL_SLOTS;
+	sp->rounds = (delay - 1) / WHEEL_SLOTS;
+	wheel[sp->slot] = g_slist_prepend(wheel[sp->slot], sp);
+}
+
+static void
+unschedule(struct selfping *sp)
+{
+	wheel[sp->slot] = g_slist_remove(wheel[sp->slot], sp);
+}
+
+static void
+free_request(struct selfping_request *req)
+{
+	g_free(req->name);
+	g_free(req);
+}
+
+static void
+selfping_reply(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from, gpointer user_data)
+{
+	struct selfping_request *req;
+	struct selfping *sp;
+	LmMessageNode *error;
+	MUC_REC *channel;
+	const char *condition;
+	int code;
+
+	req = user_data;
+	if ((channel = muc_find(server, req->name)) == NULL
+	    || (sp = g_hash_table_lookup(selfpings, channel)) == NULL)
+		return;
+	sp->waiting = FALSE;
+	/* no answer: the room or its server may be slow, try later */
+	if (lmsg == NULL || type != LM_MESSAGE_SUB_TYPE_ERROR
+	    || (error = lm_message_node_get_child(lmsg->node, "error")) == NULL)
+		return;
+	/* XEP-0410: these errors come from our own client, from a room
+	 * that doesn't route pings or from a remote server, we're still
+	 * an occupant. Any other error means we aren't anymore. */
+	if ((condition = xmpp_get_error_condition(error)) != NULL) {
+		if (strcmp(condition, "service-unavailable") == 0
+		    || strcmp(condition, "feature-not-implemented") == 0
+		    || strcmp(condition, "item-not-found") == 0
+		    || strncmp(condition, "remote-server-", 14) == 0)
+			return;
+	} else if ((code = xmpp_get_error_code(error)) == 404
+	    || code == 501 || code == 503 || code == 504)
+		return;
+	muc_rejoin(channel);
+}
+
+static void
+send_selfping(MUC_REC *channel)
+{
+	struct selfping_request *req;
+	LmMessage *lmsg;
+	LmMessageNode *node;
+	char *str, *recoded;
+
+	str = g_strconcat(channel->name, "/", channel->nick, (void *)NULL);
+	recoded = xmpp_recode_out(str);
+	g_free(str);
+	lmsg = lm_message_new_with_sub_type(recoded,
+	    LM_MESSAGE_TYPE_IQ, LM_MESSAGE_SUB_TYPE_GET);
+	g_free(recoded);
+	node = lm_message_node_add_child(lmsg->node, "ping", NULL);
+	lm_message_node_set_attribute(node, XMLNS, XMLNS_PING);
+	req = g_new0(struct selfping_request, 1);
+	req->server = channel->server;
+	req->name = g_strdup(channel->name);
+	xmpp_iq_send(channel->server, lmsg, 0, selfping_reply, req,
+	    (GDestroyNotify)free_request);
+	lm_message_unref(lmsg);
+}
+
+static int
+wheel_func(void)
+{
+	GSList *tmp, *next;
+	struct selfping *sp;
+
+	wheel_pos = (wheel_pos + 1) % WHEEL_SLOTS;
+	for (tmp = wheel[wheel_pos]; tmp != NULL; tmp = next) {
+		next = tmp->next;
+		sp = tmp->data;
+		if (sp->rounds > 0) {
+			sp->rounds--;
+			continue;
+		}
+		wheel[wheel_pos] = g_slist_delete_link(wheel[wheel_pos], tmp);
+		if (sp->channel->joined && !sp->waiting
+		    && sp->channel->server->connected) {
+			sp->waiting = TRUE;
+			send_selfping(sp->channel);
+		}
+		schedule(sp);
+	}
+	return 1;
+}
+
+static void
+sig_channel_joined(MUC_REC *channel)
+{
+	struct selfping *sp;
+
+	if (!IS_MUC(channel) || g_hash_table_lookup(selfpings, channel) != NULL)
+		return;
+	sp = g_new0(struct selfping, 1);
+	sp->channel = channel;
+	g_hash_table_insert(selfpings, channel, sp);
+	schedule(sp);
+	if (wheel_tag == 0)
+		wheel_tag = g_timeout_add(1000, (GSourceFunc)wheel_func, NULL);
+}
+
+static void
+sig_channel_destroyed(MUC_REC *channel)
+{
+	struct selfping *sp;
+
+	if (!IS_MUC(channel)
+	    || (sp = g_hash_table_lookup(selfpings, channel)) == NULL)
+		return;
+	unschedule(sp);
+	g_hash_table_remove(selfpings, channel);
+	if (g_hash_table_size(selfpings) == 0 && wheel_tag != 0) {
+		g_source_remove(wheel_tag);
+		wheel_tag = 0;
+	}
+}
+
+static void
+reschedule_func(MUC_REC *channel, struct selfping *sp)
+{
+	unschedule(sp);
+	schedule(sp);
+}
+
+static void
+read_settings(void)
+{
+	int old;
+
+	old = interval;
+	interval = settings_get_time("xmpp_muc_selfping_interval") / 1000;
+	if (interval != old)
+		g_hash_table_foreach(selfpings, (GHFunc)reschedule_func, NULL);
+}
+
+void
+muc_selfping_init(void)
+{
+	wheel_pos = 0;
+	wheel_tag = 0;
+	selfpings = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+	    NULL, g_free);
+	settings_add_time("xmpp", "xmpp_muc_selfping_interval", "5min");
+	interval = settings_get_time("xmpp_muc_selfping_interval") / 1000;
+	signal_add("channel joined", sig_channel_joined);
+	signal_add("channel destroyed", sig_channel_destroyed);
+	signal_add("setup changed", read_settings);
+}
+
+void
+muc_selfping_deinit(void)
+{
+	int i;
+
+	signal_remove("channel joined", sig_channel_joined);
+	signal_remove("channel destroyed", sig_channel_destroyed);
+	signal_remove("setup changed", read_settings);
+	if (wheel_tag != 0)
+		g_source_remove(wheel_tag);
+	for (i = 0; i < WHEEL_SLOTS; ++i) {
+		g_slist_free(wheel[i]);
+		wheel[i] = NULL;
+	}
+	g_hash_table_destroy(selfpings);
+}
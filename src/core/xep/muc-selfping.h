@@ -0,0 +1,9 @@
+#ifndef __MUC_SELFPING_H
+#define __MUC_SELFPING_H
+
+__BEGIN_DECLS
+void muc_selfping_init(void);
+void muc_selfping_deinit(void);
+__END_DECLS
+
+#endif
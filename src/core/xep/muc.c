@@ -26,20 +26,39 @@
 #include "settings.h"
 #include "signals.h"
 
+#include "jids.h"
 #include "rosters-tools.h"
 #include "tools.h"
 #include "disco.h"
 #include "muc.h"
+#include "muc-admin.h"
+#include "muc-autojoin.h"
 #include "muc-commands.h"
 #include "muc-events.h"
 #include "muc-nicklist.h"
 #include "muc-affiliation.h"
 #include "muc-role.h"
 #include "muc-reconnect.h"
+#include "muc-selfping.h"
 
 #define XMLNS_DATA_X "jabber:x:data"
 #define XMLNS_MUC_CONFIG "http://jabber.org/protocol/muc#roomconfig"
 
+/* presence broadcast to this many rooms per PRESENCE_INTERVAL msecs */
+#define PRESENCE_CHUNK		8
+#define PRESENCE_INTERVAL	200
+
+struct presence_fanout {
+	XMPP_SERVER_REC	*server;
+	LmMessage	*lmsg;
+	int		 show;
+	char		*status;
+	GSList		*rooms;
+	int		 timeout_tag;
+};
+
+static GSList *fanouts;
+
 static char *
 get_join_data(MUC_REC *channel)
 {
@@ -94,7 +113,7 @@ muc_nick(MUC_REC *channel, const char *nick)
 			g_free(recoded);
 		}
 		node = lm_message_node_add_child(node, "history", NULL);
-		str = g_strdup_printf("%d",
+		str = g_strdup_printf("%d", channel->rejoin ? 0 :
 		    settings_get_int("xmpp_history_maxstanzas"));
 		lm_message_node_set_attribute(node, "maxstanzas", str);
 		g_free(str);
@@ -111,6 +130,9 @@ muc_nick(MUC_REC *channel, const char *nick)
 			    recoded);
 			g_free(recoded);
 		}
+		channel->show = channel->server->show;
+		g_free(channel->status);
+		channel->status = g_strdup(channel->server->away_reason);
 	}
 	signal_emit("xmpp send presence", 2, channel->server, lmsg);
 	lm_message_unref(lmsg);
@@ -125,22 +147,44 @@ send_join(MUC_REC *channel)
 	muc_nick(channel, channel->nick);
 }
 
+/* Joins again a room the server doesn't consider us in anymore */
 void
+muc_rejoin(MUC_REC *channel)
+{
+	GSList *nicks, *tmp;
+
+	g_return_if_fail(IS_MUC(channel));
+	if (!channel->server->connected)
+		return;
+	signal_emit("xmpp muc rejoin", 1, channel);
+	nicks = nicklist_getnicks(CHANNEL(channel));
+	for (tmp = nicks; tmp != NULL; tmp = tmp->next)
+		nicklist_remove(CHANNEL(channel), tmp->data);
+	g_slist_free(nicks);
+	channel->ownnick = NULL;
+	channel->names_got = FALSE;
+	channel->joined = FALSE;
+	channel->rejoin = TRUE;
+	send_join(channel);
+}
+
+MUC_REC *
 muc_join(XMPP_SERVER_REC *server, const char *data, gboolean automatic)
 {
 	MUC_REC *channel;
 	char *chanline, *channame, *nick, *key;
 	void *free_arg;
 
-	g_return_if_fail(IS_XMPP_SERVER(server));
-	g_return_if_fail(data != NULL);
+	g_return_val_if_fail(IS_XMPP_SERVER(server), NULL);
+	g_return_val_if_fail(data != NULL, NULL);
 	if (!server->connected)
-		return;
+		return NULL;
 	if (!cmd_get_params(data, &free_arg, 2 | PARAM_FLAG_GETREST,
 	    &chanline, &key))
-		return;
+		return NULL;
 	nick = muc_extract_nick(chanline);
 	channame = muc_extract_channel(chanline);
+	channel = NULL;
 	if (muc_find(server, channame) == NULL) {
 		channel = (MUC_REC *)muc_create(server,
 		    channame, NULL, automatic, nick);
@@ -151,6 +195,7 @@ muc_join(XMPP_SERVER_REC *server, const char *data, gboolean automatic)
 	g_free(nick);
 	g_free(channame);
 	cmd_params_free(free_arg);
+	return channel;
 }
 
 static void
@@ -194,28 +239,9 @@ muc_part(MUC_REC *channel, const char *reason)
 void
 muc_get_affiliation(XMPP_SERVER_REC *server, MUC_REC *channel, const char *type)
 {
-	LmMessage *lmsg;
-	LmMessageNode *query, *item;
-	char *recoded;
-
 	g_return_if_fail(IS_MUC(channel));
 	g_return_if_fail(IS_XMPP_SERVER(server));
-	if (!channel->server->connected)
-		return;
-
-	lmsg = lm_message_new_with_sub_type(channel->name, LM_MESSAGE_TYPE_IQ,
-	    LM_MESSAGE_SUB_TYPE_GET);
-	recoded = xmpp_recode_out(server->jid);
-	lm_message_node_set_attribute(lmsg->node, "from", recoded);
-	g_free(recoded);
-	query = lm_message_node_add_child(lmsg->node, "query", NULL);
-	lm_message_node_set_attribute(query, XMLNS, XMLNS_MUC_ADMIN);
-	item = lm_message_node_add_child(query, "item", NULL);
-	recoded = xmpp_recode_out(type);
-	lm_message_node_set_attribute(item, "affiliation", recoded);
-	g_free(recoded);
-	signal_emit("xmpp send iq", 2, channel->server, lmsg);
-	lm_message_unref(lmsg);
+	muc_admin_list(channel, "affiliation", type);
 }
 
 void
@@ -257,28 +283,9 @@ muc_set_affiliation(XMPP_SERVER_REC *server, MUC_REC *channel, const char *type,
 void
 muc_get_role(XMPP_SERVER_REC *server, MUC_REC *channel, const char *type)
 {
-	LmMessage *lmsg;
-	LmMessageNode *query, *item;
-	char *recoded;
-
 	g_return_if_fail(IS_MUC(channel));
 	g_return_if_fail(IS_XMPP_SERVER(server));
-	if (!channel->server->connected)
-		return;
-
-	lmsg = lm_message_new_with_sub_type(channel->name, LM_MESSAGE_TYPE_IQ,
-	    LM_MESSAGE_SUB_TYPE_GET);
-	recoded = xmpp_recode_out(server->jid);
-	lm_message_node_set_attribute(lmsg->node, "from", recoded);
-	g_free(recoded);
-	query = lm_message_node_add_child(lmsg->node, "query", NULL);
-	lm_message_node_set_attribute(query, XMLNS, XMLNS_MUC_ADMIN);
-	item = lm_message_node_add_child(query, "item", NULL);
-	recoded = xmpp_recode_out(type);
-	lm_message_node_set_attribute(item, "role", recoded);
-	g_free(recoded);
-	signal_emit("xmpp send iq", 2, channel->server, lmsg);
-	lm_message_unref(lmsg);
+	muc_admin_list(channel, "role", type);
 }
 
 void
@@ -469,6 +476,7 @@ sig_channel_destroyed(MUC_REC *channel)
 	if (!channel->server->disconnected && !channel->left)
 		muc_part(channel, settings_get_str("part_message"));
 	g_free(channel->nick);
+	g_free(channel->status);
 }
 
 static CHANNEL_REC *
@@ -476,15 +484,19 @@ channel_find_func(SERVER_REC *server, const char *channel_name)
 {
 	GSList *tmp;
 	CHANNEL_REC *channel;
+	char *canonical;
 
+	/* the names keep the spelling they were joined with */
+	canonical = g_strdup(xmpp_jid_canonical(channel_name));
 	for (tmp = server->channels; tmp != NULL; tmp = tmp->next) {
 		channel = tmp->data;
 		if (channel->chat_type != server->chat_type)
 			continue;
-		if (g_ascii_strcasecmp(channel_name, channel->name) == 0)
-			return channel;
+		if (strcmp(canonical, xmpp_jid_canonical(channel->name)) == 0)
+			break;
 	}
-	return NULL;
+	g_free(canonical);
+	return tmp != NULL ? tmp->data : NULL;
 }
 
 static void
@@ -524,7 +536,7 @@ static void
 sig_connected(SERVER_REC *server)
 {
 	GSList *tmp;
-	CHANNEL_SETUP_REC *channel_setup;
+	MUC_SETUP_REC *channel_setup;
 
 	if (!IS_XMPP_SERVER(server))
 		return;
@@ -534,38 +546,139 @@ sig_connected(SERVER_REC *server)
 	/* autojoin channels */
 	if (!server->connrec->no_autojoin_channels) {
 		for (tmp = setupchannels; tmp != NULL; tmp = tmp->next) {
-			channel_setup = tmp->data;
-			if (IS_MUC_SETUP(channel_setup)
-			    && channel_setup->autojoin
+			channel_setup = MUC_SETUP(tmp->data);
+			if (channel_setup != NULL && channel_setup->autojoin
 			    && strcmp(channel_setup->chatnet,
 			    server->connrec->chatnet) == 0)
-				 muc_join(XMPP_SERVER(server),
-				     channel_setup->name, TRUE);
+				muc_autojoin_add(XMPP_SERVER(server),
+				    channel_setup->name,
+				    channel_setup->priority);
 		}
+		muc_autojoin_start(XMPP_SERVER(server));
 	}
 }
 
+static struct presence_fanout *
+find_fanout(XMPP_SERVER_REC *server)
+{
+	GSList *tmp;
+
+	for (tmp = fanouts; tmp != NULL; tmp = tmp->next)
+		if (((struct presence_fanout *)tmp->data)->server == server)
+			return tmp->data;
+	return NULL;
+}
+
 static void
-send_muc_presence(MUC_REC *channel, const int show, const char *status)
+fanout_destroy(struct presence_fanout *fanout)
 {
-	LmMessage *lmsg;
-	char *channame, *str;
+	fanouts = g_slist_remove(fanouts, fanout);
+	if (fanout->timeout_tag != 0)
+		g_source_remove(fanout->timeout_tag);
+	lm_message_unref(fanout->lmsg);
+	g_free(fanout->status);
+	g_slist_free_full(fanout->rooms, g_free);
+	g_free(fanout);
+}
+
+static gboolean
+presence_sent(MUC_REC *channel, int show, const char *status)
+{
+	return channel->show == show
+	    && g_strcmp0(channel->status, status) == 0;
+}
+
+/* the payload is built once, only the recipient changes */
+static void
+send_muc_presence(struct presence_fanout *fanout, MUC_REC *channel)
+{
+	char *channame, *recoded;
 
 	channame = g_strconcat(channel->name, "/", channel->nick, (void *)NULL);
-	str = xmpp_recode_out(channame);
+	recoded = xmpp_recode_out(channame);
 	g_free(channame);
-	lmsg = lm_message_new(str, LM_MESSAGE_TYPE_PRESENCE);
-	g_free(str);
-	if (show != XMPP_PRESENCE_AVAILABLE)
-		lm_message_node_add_child(lmsg->node, "show",
-		    xmpp_presence_show[show]);
-	if (status != NULL) {
-		str = xmpp_recode_out(status);
-		lm_message_node_add_child(lmsg->node, "status", str);
-		g_free(str);
+	lm_message_node_set_attribute(fanout->lmsg->node, "to", recoded);
+	g_free(recoded);
+	signal_emit("xmpp send presence", 2, channel->server, fanout->lmsg);
+	channel->show = fanout->show;
+	g_free(channel->status);
+	channel->status = g_strdup(fanout->status);
+}
+
+static gboolean
+fanout_func(struct presence_fanout *fanout)
+{
+	MUC_REC *channel;
+	char *name;
+	int sent;
+
+	for (sent = 0; sent < PRESENCE_CHUNK && fanout->rooms != NULL;) {
+		name = fanout->rooms->data;
+		fanout->rooms = g_slist_delete_link(fanout->rooms,
+		    fanout->rooms);
+		/* the room may have been left or parted meanwhile */
+		channel = muc_find(fanout->server, name);
+		g_free(name);
+		if (channel == NULL || !channel->joined
+		    || presence_sent(channel, fanout->show, fanout->status))
+			continue;
+		send_muc_presence(fanout, channel);
+		sent++;
 	}
-	signal_emit("xmpp send presence", 2, channel->server, lmsg);
-	lm_message_unref(lmsg);
+	if (fanout->rooms != NULL)
+		return TRUE;
+	fanout->timeout_tag = 0;
+	fanout_destroy(fanout);
+	return FALSE;
+}
+
+static void
+fanout_add(XMPP_SERVER_REC *server, MUC_REC *channel, const int show,
+    const char *status)
+{
+	struct presence_fanout *fanout;
+	char *recoded;
+
+	fanout = find_fanout(server);
+	if (fanout == NULL || fanout->show != show
+	    || g_strcmp0(fanout->status, status) != 0) {
+		/* a newer presence supersedes the one being sent */
+		if (fanout != NULL)
+			fanout_destroy(fanout);
+		fanout = g_new0(struct presence_fanout, 1);
+		fanout->server = server;
+		fanout->show = show;
+		fanout->status = g_strdup(status);
+		fanout->lmsg = lm_message_new(NULL, LM_MESSAGE_TYPE_PRESENCE);
+		if (show != XMPP_PRESENCE_AVAILABLE)
+			lm_message_node_add_child(fanout->lmsg->node, "show",
+			    xmpp_presence_show[show]);
+		if (status != NULL) {
+			recoded = xmpp_recode_out(status);
+			lm_message_node_add_child(fanout->lmsg->node,
+			    "status", recoded);
+			g_free(recoded);
+		}
+		fanouts = g_slist_prepend(fanouts, fanout);
+	}
+	if (g_slist_find_custom(fanout->rooms, channel->name,
+	    (GCompareFunc)strcmp) == NULL)
+		fanout->rooms = g_slist_append(fanout->rooms,
+		    g_strdup(channel->name));
+}
+
+static void
+fanout_start(XMPP_SERVER_REC *server)
+{
+	struct presence_fanout *fanout;
+
+	if ((fanout = find_fanout(server)) == NULL
+	    || fanout->timeout_tag != 0)
+		return;
+	/* the first rooms right away */
+	if (fanout_func(fanout))
+		fanout->timeout_tag = g_timeout_add(PRESENCE_INTERVAL,
+		    (GSourceFunc)fanout_func, fanout);
 }
 
 static void
@@ -574,14 +687,47 @@ sig_set_presence(XMPP_SERVER_REC *server, const int show, const char *status,
 {
 	GSList *tmp;
 	MUC_REC *channel;
+	struct presence_fanout *fanout;
 
 	g_return_if_fail(IS_XMPP_SERVER(server));
 	if (!server->connected)
 		return;
+	if ((fanout = find_fanout(server)) != NULL
+	    && (fanout->show != show
+	    || g_strcmp0(fanout->status, status) != 0))
+		fanout_destroy(fanout);
 	for (tmp = server->channels; tmp != NULL; tmp = tmp->next) {
 		channel = MUC(tmp->data);
-		send_muc_presence(channel, show, status);
+		if (channel != NULL && channel->joined
+		    && !presence_sent(channel, show, status))
+			fanout_add(server, channel, show, status);
 	}
+	fanout_start(server);
+}
+
+static void
+sig_channel_joined(MUC_REC *channel)
+{
+	XMPP_SERVER_REC *server;
+
+	if (!IS_MUC(channel))
+		return;
+	/* our presence changed while we were joining */
+	server = channel->server;
+	if (!presence_sent(channel, server->show, server->away_reason)) {
+		fanout_add(server, channel, server->show,
+		    server->away_reason);
+		fanout_start(server);
+	}
+}
+
+static void
+sig_disconnected(XMPP_SERVER_REC *server)
+{
+	struct presence_fanout *fanout;
+
+	if (IS_XMPP_SERVER(server) && (fanout = find_fanout(server)) != NULL)
+		fanout_destroy(fanout);
 }
 
 void
@@ -594,16 +740,21 @@ muc_init(void)
 		    (SERVER_REC *, const char *, const char *, int))muc_create;
 
 	disco_add_feature(XMLNS_MUC);
+	muc_admin_init();
+	muc_autojoin_init();
 	muc_commands_init();
 	muc_events_init();
 	muc_nicklist_init();
 	muc_reconnect_init();
+	muc_selfping_init();
 
 	signal_add("xmpp features", sig_features);
 	signal_add("channel created", sig_channel_created);
 	signal_add("channel destroyed", sig_channel_destroyed);
 	signal_add("server connected", sig_connected);
 	signal_add("xmpp set presence", sig_set_presence);
+	signal_add("channel joined", sig_channel_joined);
+	signal_add("server disconnected", sig_disconnected);
 
 	settings_add_int("xmpp_lookandfeel", "xmpp_history_maxstanzas", 30);
 }
@@ -616,9 +767,16 @@ muc_deinit(void)
 	signal_remove("channel destroyed",sig_channel_destroyed);
 	signal_remove("server connected", sig_connected);
 	signal_remove("xmpp set presence", sig_set_presence);
+	signal_remove("channel joined", sig_channel_joined);
+	signal_remove("server disconnected", sig_disconnected);
+	while (fanouts != NULL)
+		fanout_destroy(fanouts->data);
 
+	muc_admin_deinit();
+	muc_autojoin_deinit();
 	muc_commands_deinit();
 	muc_events_deinit();
 	muc_nicklist_deinit();
 	muc_reconnect_deinit();
+	muc_selfping_deinit();
 }
@@ -17,7 +17,7 @@
 	xmpp_strip_resource(jid)
 
 #define MUC_SETUP(chansetup) \
-	PROTO_CHECK_CAST(CHANNEL_SETUP(chansetup), CHANNEL_SETUP_REC, chat_type, "XMPP")
+	PROTO_CHECK_CAST(CHANNEL_SETUP(chansetup), MUC_SETUP_REC, chat_type, "XMPP")
 
 #define IS_MUC_SETUP(chansetup) \
 	(MUC_SETUP(chansetup) ? TRUE : FALSE)
@@ -37,6 +37,17 @@ struct _MUC_REC {
 	#include "channel-rec.h"
 
 	char	*nick;
+	int	 show;		/* the presence last sent to the room */
+	char	*status;
+
+	GHashTable *real_jids;	/* bare real JID -> occupants */
+	gboolean rejoin;	/* joined before, the history was received */
+};
+
+struct _MUC_SETUP_REC {
+	#include "channel-setup-rec.h"
+
+	int	 priority;
 };
 
 enum {
@@ -54,8 +65,9 @@ enum {
 __BEGIN_DECLS
 
 void muc_destroy(XMPP_SERVER_REC *, MUC_REC *, const char *, const char *);
-void muc_join(XMPP_SERVER_REC *, const char *, gboolean);
+MUC_REC	*muc_join(XMPP_SERVER_REC *, const char *, gboolean);
 void muc_part(MUC_REC *, const char *);
+void muc_rejoin(MUC_REC *);
 void muc_nick(MUC_REC *, const char *);
 void muc_get_affiliation(XMPP_SERVER_REC *, MUC_REC *, const char *);
 void muc_set_affiliation(XMPP_SERVER_REC *, MUC_REC *, const char *,
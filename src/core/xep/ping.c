@@ -30,25 +30,49 @@
 
 #include "xmpp-servers.h"
 #include "xmpp-commands.h"
-#include "tool_datalist.h"
 #include "disco.h"
+#include "iq.h"
 #include "tools.h"
 
 #define XMLNS_PING "urn:xmpp:ping"
 
-struct ping_data {
-	char	 *id;
-	GTimeVal  time;
-};
-
 static int	 timeout_tag;
 static GSList	*supported_servers;
-static DATALIST *pings;
+
+static void
+server_pong(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from, gpointer user_data)
+{
+	GTimeVal now;
+
+	/* without a reply, the lag check disconnects the server */
+	if (lmsg == NULL)
+		return;
+	g_get_current_time(&now);
+	server->lag = (int)get_timeval_diff(&now, &server->lag_sent);
+	memset(&server->lag_sent, 0, sizeof(server->lag_sent));
+	signal_emit("server lag", 1, server);
+}
+
+static void
+pong(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from, gpointer user_data)
+{
+	GTimeVal now;
+
+	if (lmsg == NULL || type != LM_MESSAGE_SUB_TYPE_RESULT) {
+		xmpp_iq_report(server, lmsg, from, "ping");
+		return;
+	}
+	g_get_current_time(&now);
+	signal_emit("xmpp ping", 3, server, from,
+	    get_timeval_diff(&now, user_data));
+}
 
 static void
 request_ping(XMPP_SERVER_REC *server, const char *dest)
 {
-	struct ping_data *pd;
+	GTimeVal *sent;
 	LmMessage *lmsg;
 	LmMessageNode *node;
 	char *recoded;
@@ -60,19 +84,16 @@ request_ping(XMPP_SERVER_REC *server, const char *dest)
 	node = lm_message_node_add_child(lmsg->node, "ping", NULL);
 	lm_message_node_set_attribute(node, XMLNS, XMLNS_PING);
 	if (strcmp(dest, server->domain) == 0) {
-		g_free(server->ping_id);
-		server->ping_id =
-		    g_strdup(lm_message_node_get_attribute(lmsg->node, "id"));
 		g_get_current_time(&server->lag_sent);
 		server->lag_last_check = time(NULL);
+		xmpp_iq_send(server, lmsg,
+		    settings_get_time("lag_max_before_disconnect"),
+		    server_pong, NULL, NULL);
 	} else {
-		pd = g_new0(struct ping_data, 1);
-		pd->id =
-		    g_strdup(lm_message_node_get_attribute(lmsg->node, "id"));
-		g_get_current_time(&pd->time);
-		datalist_add(pings, server, dest, pd);
+		sent = g_new(GTimeVal, 1);
+		g_get_current_time(sent);
+		xmpp_iq_send(server, lmsg, 0, pong, sent, g_free);
 	}
-	signal_emit("xmpp send iq", 2, server, lmsg);
 	lm_message_unref(lmsg);
 }
 
@@ -96,32 +117,9 @@ static void
 sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
     const char *id, const char *from, const char *to)
 {
-	DATALIST_REC *rec;
 	LmMessageNode *node;
-	GTimeVal now;
-	struct ping_data *pd;
-
-	if (type == LM_MESSAGE_SUB_TYPE_RESULT) {
-		/* pong response from server of our ping */
-		if (server->ping_id != NULL
-		    && (*from == '\0' || strcmp(from, server->domain) == 0)
-	    	    && strcmp(id, server->ping_id) == 0) {
-			g_get_current_time(&now);
-			server->lag =
-			    (int)get_timeval_diff(&now, &server->lag_sent);
-			memset(&server->lag_sent, 0, sizeof(server->lag_sent));
-			g_free_and_null(server->ping_id);
-			signal_emit("server lag", 1, server);
-		} else if (lmsg->node->children == NULL
-		    && (rec = datalist_find(pings, server, from)) != NULL) {
-			pd = rec->data;
-			if (strcmp(id, pd->id) == 0) {
-				g_get_current_time(&now);
-				signal_emit("xmpp ping", 3, server, from,
-				    get_timeval_diff(&now, &pd->time));
-			}
-		}
-	} else if (type == LM_MESSAGE_SUB_TYPE_GET) {
+
+	if (type == LM_MESSAGE_SUB_TYPE_GET) {
 		node = lm_find_node(lmsg->node, "ping", XMLNS, XMLNS_PING);
 		if (node == NULL)
 			node = lm_find_node(lmsg->node, "query", XMLNS,
@@ -148,7 +146,6 @@ sig_disconnected(XMPP_SERVER_REC *server)
 	if (!IS_XMPP_SERVER(server))
 		return;
 	supported_servers = g_slist_remove(supported_servers, server);
-	datalist_cleanup(pings, server);
 }
 
 static int
@@ -201,18 +198,10 @@ cmd_ping(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 	cmd_params_free(free_arg);
 }
 
-static void
-freedata_func(DATALIST_REC *rec)
-{
-	g_free(((struct ping_data *)rec->data)->id);
-	g_free(rec->data);
-}
-
 void
 ping_init(void)
 {
 	supported_servers = NULL;
-	pings = datalist_new(freedata_func);
 	disco_add_feature(XMLNS_PING);
 	signal_add("xmpp recv iq", sig_recv_iq);
 	signal_add("xmpp server features", sig_server_features);
@@ -230,5 +219,4 @@ ping_deinit(void)
 	signal_remove("server disconnected", sig_disconnected);
 	command_unbind("ping", (SIGNAL_FUNC)cmd_ping);
 	g_slist_free(supported_servers);
-	datalist_destroy(pings);
 }
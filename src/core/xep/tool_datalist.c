@@ -19,6 +19,7 @@
 
 #include "module.h"
 
+#include "jids.h"
 #include "tool_datalist.h"
 
 DATALIST_REC *
@@ -26,10 +27,14 @@ datalist_find(DATALIST *dl, XMPP_SERVER_REC *server, const char *jid)
 {
 	GSList *tmp;
 	DATALIST_REC *rec;
+	char *atom;
 
+	/* every jid of the list is an atom */
+	if ((atom = xmpp_jid_lookup(jid)) == NULL)
+		return NULL;
 	for (tmp = dl->list; tmp != NULL; tmp = tmp->next) {
 		rec = tmp->data;
-		if (rec->server == server && strcmp(rec->jid, jid) == 0)
+		if (rec->server == server && rec->jid == atom)
 				return rec;
 	}
 	return NULL;
@@ -47,7 +52,7 @@ datalist_add(DATALIST *dl, XMPP_SERVER_REC *server, const char *jid,
 	} else {
 		rec = g_new0(DATALIST_REC, 1);
 		rec->server = server;
-		rec->jid = g_strdup(jid);
+		rec->jid = xmpp_jid_ref(jid);
 		rec->data = data;
 		dl->list = g_slist_prepend(dl->list, rec);
 	}
@@ -58,7 +63,7 @@ void
 datalist_free(DATALIST *dl, DATALIST_REC *rec)
 {
 	dl->list = g_slist_remove(dl->list, rec);
-	g_free(rec->jid);
+	xmpp_jid_unref(rec->jid);
 	dl->freedata_func(rec);
 	g_free(rec);
 }
@@ -23,43 +23,10 @@
 #include "xmpp-commands.h"
 #include "tools.h"
 #include "disco.h"
+#include "iq.h"
 
 #define XMLNS_VCARD "vcard-temp"
 
-static void
-request_vcard(XMPP_SERVER_REC *server, const char *dest)
-{
-	LmMessage *lmsg;
-	LmMessageNode *node;
-	char *recoded;
-
-	recoded = xmpp_recode_out(dest);
-	lmsg = lm_message_new_with_sub_type(recoded,
-	    LM_MESSAGE_TYPE_IQ, LM_MESSAGE_SUB_TYPE_GET);
-	g_free(recoded);
-	node = lm_message_node_add_child(lmsg->node, "vCard", NULL);
-	lm_message_node_set_attribute(node, XMLNS, XMLNS_VCARD);
-	signal_emit("xmpp send iq", 2, server, lmsg);		
-	lm_message_unref(lmsg);
-}
-
-/* SYNTAX: VCARD [<jid>|<name>]
- * SYNTAX: WHOIS [<jid>|<name>] */
-static void
-cmd_vcard(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
-{
-	char *cmd_dest, *dest;
-	void *free_arg;
-
-	CMD_XMPP_SERVER(server);
-	if (!cmd_get_params(data, &free_arg, 1, &cmd_dest))
-		return;
-	dest = xmpp_get_dest(cmd_dest, server, item);
-	request_vcard(server, dest);
-	g_free(dest);
-	cmd_params_free(free_arg);
-}
-
 static void
 vcard_handle(XMPP_SERVER_REC *server, const char *jid, LmMessageNode *node)
 {
@@ -109,25 +76,60 @@ next:
 }
 
 static void
-sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
-    const char *id, const char *from, const char *to)
+vcard_reply(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from, gpointer user_data)
 {
 	LmMessageNode *node;
 
-	if (type != LM_MESSAGE_SUB_TYPE_RESULT)
+	if (lmsg == NULL || type != LM_MESSAGE_SUB_TYPE_RESULT) {
+		xmpp_iq_report(server, lmsg, from, "vCard");
 		return;
+	}
 	node = lm_find_node(lmsg->node, "vCard", XMLNS, XMLNS_VCARD);
 	if (node != NULL)
 		vcard_handle(server, from, node);
 }
 
+static void
+request_vcard(XMPP_SERVER_REC *server, const char *dest)
+{
+	LmMessage *lmsg;
+	LmMessageNode *node;
+	char *recoded;
+
+	recoded = xmpp_recode_out(dest);
+	lmsg = lm_message_new_with_sub_type(recoded,
+	    LM_MESSAGE_TYPE_IQ, LM_MESSAGE_SUB_TYPE_GET);
+	g_free(recoded);
+	node = lm_message_node_add_child(lmsg->node, "vCard", NULL);
+	lm_message_node_set_attribute(node, XMLNS, XMLNS_VCARD);
+	xmpp_iq_send(server, lmsg, 0, vcard_reply, NULL, NULL);
+	lm_message_unref(lmsg);
+}
+
+/* SYNTAX: VCARD [<jid>|<name>]
+ * SYNTAX: WHOIS [<jid>|<name>] */
+static void
+cmd_vcard(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
+{
+	char *cmd_dest, *dest;
+	void *free_arg;
+
+	CMD_XMPP_SERVER(server);
+	if (!cmd_get_params(data, &free_arg, 1, &cmd_dest))
+		return;
+	dest = xmpp_get_dest(cmd_dest, server, item);
+	request_vcard(server, dest);
+	g_free(dest);
+	cmd_params_free(free_arg);
+}
+
 void
 vcard_init(void)
 {
 	disco_add_feature(XMLNS_VCARD);
 	command_bind_xmpp("vcard", NULL, (SIGNAL_FUNC)cmd_vcard);
 	command_bind_xmpp("whois", NULL, (SIGNAL_FUNC)cmd_vcard);
-	signal_add("xmpp recv iq", sig_recv_iq);
 }
 
 void
@@ -135,5 +137,4 @@ vcard_deinit(void)
 {
 	command_unbind("vcard", (SIGNAL_FUNC)cmd_vcard);
 	command_unbind("whois", (SIGNAL_FUNC)cmd_vcard);
-	signal_remove("xmpp recv iq", sig_recv_iq);
 }
@@ -30,6 +30,7 @@
 #include "xmpp-servers.h"
 #include "xmpp-commands.h"
 #include "disco.h"
+#include "iq.h"
 #include "tools.h"
 
 #define XMLNS_VERSION "jabber:iq:version"
@@ -63,6 +64,38 @@ send_version(XMPP_SERVER_REC *server, const char *dest,
 	lm_message_unref(lmsg);
 }
 
+static void
+version_reply(XMPP_SERVER_REC *server, LmMessage *lmsg, int type,
+    const char *from, gpointer user_data)
+{
+	LmMessageNode *node, *child;
+	char *name, *version, *os;
+
+	if (lmsg == NULL || type != LM_MESSAGE_SUB_TYPE_RESULT) {
+		xmpp_iq_report(server, lmsg, from, "version");
+		return;
+	}
+	if ((node = lm_find_node(lmsg->node,"query", XMLNS,
+	    XMLNS_VERSION)) == NULL)
+		return;
+	name = version = os = NULL;
+	for (child = node->children; child != NULL; child = child->next) {
+		if (child->value == NULL)
+			continue;
+		if (name == NULL && strcmp(child->name, "name") == 0)
+			g_strstrip(name = xmpp_recode_in(child->value));
+		else if (version == NULL
+		    && strcmp(child->name, "version") == 0)
+			g_strstrip(version = xmpp_recode_in(child->value));	
+		else if (os  == NULL && strcmp(child->name, "os") == 0)
+			g_strstrip(os = xmpp_recode_in(child->value));
+	}
+	signal_emit("xmpp version", 5, server, from, name, version, os);
+	g_free(name);
+	g_free(version);
+	g_free(os);
+}
+
 static void
 request_version(XMPP_SERVER_REC *server, const char *dest)
 {
@@ -76,7 +109,7 @@ request_version(XMPP_SERVER_REC *server, const char *dest)
 	g_free(recoded);
 	node = lm_message_node_add_child(lmsg->node, "query", NULL);
 	lm_message_node_set_attribute(node, XMLNS, XMLNS_VERSION);
-	signal_emit("xmpp send iq", 2, server, lmsg);
+	xmpp_iq_send(server, lmsg, 0, version_reply, NULL, NULL);
 	lm_message_unref(lmsg);
 }
 
@@ -100,31 +133,8 @@ static void
 sig_recv_iq(XMPP_SERVER_REC *server, LmMessage *lmsg, const int type,
     const char *id, const char *from, const char *to)
 {
-	LmMessageNode *node, *child;
-	char *name, *version, *os;
-
-	if (type == LM_MESSAGE_SUB_TYPE_RESULT
-	    && (node = lm_find_node(lmsg->node,"query", XMLNS,
-	    XMLNS_VERSION)) != NULL) {
-		name = version = os = NULL;
-		for (child = node->children; child != NULL; child = child->next) {
-			if (child->value == NULL)
-				continue;
-			if (name == NULL && strcmp(child->name, "name") == 0)
-				g_strstrip(name = xmpp_recode_in(child->value));
-			else if (version == NULL
-			    && strcmp(child->name, "version") == 0)
-				g_strstrip(version = xmpp_recode_in(child->value));	
-			else if (os  == NULL && strcmp(child->name, "os") == 0)
-				g_strstrip(os = xmpp_recode_in(child->value));
-		}
-		signal_emit("xmpp version", 5, server, from, name, version, os);
-		g_free(name);
-		g_free(version);
-		g_free(os);
-	} else if (type == LM_MESSAGE_SUB_TYPE_GET
-	    && (node = lm_find_node(lmsg->node,"query", XMLNS,
-	    XMLNS_VERSION)) != NULL)
+	if (type == LM_MESSAGE_SUB_TYPE_GET
+	    && lm_find_node(lmsg->node,"query", XMLNS, XMLNS_VERSION) != NULL)
 		send_version(server, from, id);
 }
 
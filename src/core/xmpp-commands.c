@@ -29,6 +29,7 @@
 #include "xmpp-queries.h"
 #include "xmpp-servers.h"
 #include "rosters-tools.h"
+#include "stanzas.h"
 #include "tools.h"
 
 const char *xmpp_commands[] = {
@@ -195,21 +196,31 @@ cmd_quote(const char *data, XMPP_SERVER_REC *server)
 	if (*data == '\0')
 		cmd_return_error(CMDERR_NOT_ENOUGH_PARAMS);
 	signal_emit("xmpp xml out", 2, server, data);
+	/* keep the raw data ordered with the queued stanzas */
+	stanzas_flush(server);
 	recoded = xmpp_recode_out(data);
 	lm_connection_send_raw(server->lmconn, recoded, NULL);
 	g_free(recoded);
 }
 
-/* SYNTAX: ROSTER */
+/* SYNTAX: ROSTER [-online] [-group <group>] [-find <text>] [-page <n>] */
 static void
 cmd_roster(const char *data, XMPP_SERVER_REC *server, WI_ITEM_REC *item)
 {
+	GHashTable *optlist;
+	void *free_arg;
+
 	CMD_XMPP_SERVER(server);
-	if (*data == '\0')
-		signal_emit("xmpp roster show", 1, server);
-	else
+	if (*data != '\0' && *data != '-') {
 		command_runsub(xmpp_commands[XMPP_COMMAND_ROSTER], data,
 		    server, item);
+		return;
+	}
+	if (!cmd_get_params(data, &free_arg, PARAM_FLAG_OPTIONS,
+	    "roster", &optlist))
+		return;
+	signal_emit("xmpp roster show", 2, server, optlist);
+	cmd_params_free(free_arg);
 }
 
 /* SYNTAX: ROSTER FULL */
@@ -562,6 +573,7 @@ xmpp_commands_init(void)
 	command_bind_xmpp("away", NULL, (SIGNAL_FUNC)cmd_away);
 	command_bind_xmpp("quote", NULL, (SIGNAL_FUNC)cmd_quote);
 	command_bind_xmpp("roster", NULL, (SIGNAL_FUNC)cmd_roster);
+	command_set_options("roster", "online -group -find @page");
 	command_bind_xmpp("roster full", NULL, (SIGNAL_FUNC)cmd_roster_full);
 	command_bind_xmpp("roster add", NULL, (SIGNAL_FUNC)cmd_roster_add);
 	command_set_options("roster add", "nosub");
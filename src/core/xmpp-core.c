@@ -29,9 +29,15 @@
 #include "xmpp-servers.h"
 #include "xmpp-servers-reconnect.h"
 #include "xmpp-settings.h"
+#include "capture.h"
+#include "iq.h"
+#include "jids.h"
 #include "protocol.h"
 #include "rosters.h"
 #include "stanzas.h"
+#include "timeline.h"
+#include "tools.h"
+#include "xep/muc.h"
 #include "xep/xep.h"
 
 static CHATNET_REC *
@@ -61,7 +67,7 @@ create_server_connect(void)
 static CHANNEL_SETUP_REC *
 create_channel_setup(void)
 {
-	return g_new0(CHANNEL_SETUP_REC, 1);
+	return (CHANNEL_SETUP_REC *)g_new0(MUC_SETUP_REC, 1);
 }
 
 static void
@@ -101,6 +107,8 @@ xmpp_core_init(void)
 	chat_protocol_register(rec);
 	g_free(rec);
 
+	jids_init();
+	tools_init();
 	xmpp_commands_init();
 	xmpp_servers_init();
 	xmpp_servers_reconnect_init();
@@ -108,6 +116,9 @@ xmpp_core_init(void)
 	protocol_init();
 	rosters_init();
 	stanzas_init();
+	iq_init();
+	timeline_init();
+	capture_init();
 	xep_init();
 
 	module_register("xmpp", "core");
@@ -125,9 +136,14 @@ xmpp_core_deinit(void)
 	protocol_deinit();
 	rosters_deinit();
 	stanzas_deinit();
+	iq_deinit();
+	timeline_deinit();
+	capture_deinit();
+	tools_deinit();
 
 	signal_emit("chat protocol deinit", 1, chat_protocol_find("XMPP"));
 	chat_protocol_unregister("XMPP");
+	jids_deinit();
 }
 
 #ifdef IRSSI_ABI_VERSION
@@ -30,6 +30,7 @@
 #include "xmpp-servers.h"
 #include "protocol.h"
 #include "rosters-tools.h"
+#include "timeline.h"
 #include "tools.h"
 
 /* IRSSI_ABI_VERSION was introduced in 0.8.18 */
@@ -127,7 +128,6 @@ server_cleanup(XMPP_SERVER_REC *server)
 	g_free(server->user); server->user = NULL;
 	g_free(server->domain); server->domain = NULL;
 	g_free(server->resource); server->resource = NULL;
-	g_free(server->ping_id); server->ping_id = NULL;
 }
 
 SERVER_REC *
@@ -157,11 +157,12 @@ xmpp_server_init_connect(SERVER_CONNECT_REC *connrec)
 	server->priority = settings_get_int("xmpp_priority");
 	if (xmpp_priority_out_of_bound(server->priority))
 		server->priority = 0;
-	server->ping_id = NULL;
 	server->server_features = NULL;
 	server->my_resources = NULL;
 	server->roster = NULL;
 	server->msg_handlers = NULL;
+	server->iq_requests = NULL;
+	server->timeline = NULL;
 	server->channels_join = channels_join;
 	server->isnickflag = isnickflag_func;
 	server->ischannel = ischannel_func;
@@ -263,6 +264,7 @@ lm_auth_cb(LmConnection *connection, gboolean success,
 		server_connect_failed(SERVER(server), "Authentication failed");
 		return;
 	}
+	xmpp_timeline_mark(server, "authenticated");
 	signal_emit("xmpp server status", 2, server,
 	    "Authenticated successfully.");
 
@@ -542,6 +544,7 @@ sig_connected(XMPP_SERVER_REC *server)
 	g_free(str);
 	signal_emit("xmpp send presence", 2, server, lmsg);
 	lm_message_unref(lmsg);
+	xmpp_timeline_mark(server, "presence sent");
 }
 
 static void
@@ -6,9 +6,18 @@
 
 #include "loudmouth/loudmouth.h"
 #include "loudmouth-tools.h"
+#include "rosters.h"
 
 #define XMPP_PROXY_HTTP "http"
 
+/* outbound stanza classes, by scheduling priority */
+enum {
+	XMPP_SEND_INTERACTIVE,
+	XMPP_SEND_NORMAL,
+	XMPP_SEND_BULK,
+	XMPP_SEND_CLASSES
+};
+
 /* returns XMPP_SERVER_REC if it's XMPP server, NULL if it isn't */
 #define XMPP_SERVER(server)						\
 	PROTO_CHECK_CAST(SERVER(server), XMPP_SERVER_REC, chat_type, "XMPP")
@@ -44,14 +53,34 @@ struct _XMPP_SERVER_REC {
 
 	int		 show;
 	int		 priority;
-	char		*ping_id;
 	GSList		*server_features;
 	GSList		*my_resources;
 	GSList		*roster;
+	int		 roster_counts[XMPP_PRESENCE_SHOW_LEN];
 
 	int		 timeout_tag;
 	LmConnection	*lmconn;
 	GSList		*msg_handlers;
+	GHashTable	*iq_requests;
+	GHashTable	*blocked;	/* JID atom -> blocked by */
+
+	GSList		*timeline;
+	int		 timeline_length;
+	gboolean	 timeline_presence;
+
+	GQueue		 send_queues[XMPP_SEND_CLASSES];
+	gsize		 send_queued;
+	GHashTable	*send_dests;	/* dest -> queued stanzas per class */
+	gint64		 send_tokens;
+	gint64		 send_refill_time;
+	int		 send_idle_tag;
+	int		 send_timeout_tag;
+	int		 send_throttle_tag;
+	GHashTable	*flood_buckets;
+	int		 flood_report_tag;
+	gint64		 flood_prune_time;
+	unsigned long	 flood_dropped;
+	gboolean	 replaying;
 };
 
 __BEGIN_DECLS
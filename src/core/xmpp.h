@@ -6,6 +6,7 @@ typedef struct _XMPP_SERVER_REC XMPP_SERVER_REC;
 typedef struct _XMPP_QUERY_REC XMPP_QUERY_REC;
 typedef struct _XMPP_NICK_REC XMPP_NICK_REC;
 typedef struct _MUC_REC MUC_REC;
+typedef struct _MUC_SETUP_REC MUC_SETUP_REC;
 
 #define XMPP_PROTOCOL_NAME "XMPP"
 #define XMPP_PROTOCOL (chat_protocol_lookup(XMPP_PROTOCOL_NAME))
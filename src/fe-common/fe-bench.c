@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/*
+ * Micro-benchmarks of the code paths run for every stanza, to compare
+ * them on a given build: /XMPPBENCH recode|datetime
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "module.h"
+#include "commands.h"
+#include "levels.h"
+#include "module-formats.h"
+#include "printtext.h"
+#include "signals.h"
+
+#include "tools.h"
+#include "xep/datetime.h"
+
+#define BENCH_COUNT	100000
+
+/* typical message bodies, most of them without anything to strip */
+static const char *bench_bodies[] = {
+	"ok",
+	"see you tomorrow then",
+	"I pushed the fix, can you have a look at the build when you get a "
+	    "chance? It should be green now.",
+	"ça marche, à demain",
+	"\002important:\002 the meeting is moved to 3pm",
+	"> quoted line\nand the answer below it, on a second line\n"
+	    "then a third one with some more words to make it longer than "
+	    "the others, as pasted logs or long explanations usually are",
+	NULL
+};
+
+/* XEP-0082 and XEP-0091 stamps, and what xep82_datetime() returns */
+static const struct {
+	const char	*stamp;
+	time_t		 t;
+} datetime_cases[] = {
+	{ "2002-09-10T23:41:07Z", 1031701267 },
+	{ "2002-09-10T23:41:07", 1031701267 },
+	{ "2002-09-10T23:41:07.123Z", 1031701267 },
+	{ "2002-09-10T23:41:07.123456789Z", 1031701267 },
+	{ "2002-09-10T23:41:07-07:00", 1031726467 },
+	{ "2002-09-10T23:41:07.5-0700", 1031726467 },
+	{ "2002-09-10T23:41:07+05:30", 1031681467 },
+	{ "2002-09-10T23:41:07+00:00", 1031701267 },
+	{ "20020910T23:41:07", 1031701267 },
+	{ "1970-01-01T00:00:00Z", 0 },
+	{ "2000-02-29T00:00:00Z", 951782400 },
+	{ "2016-12-31T23:59:60Z", 1483228800 },
+	{ "2001-02-29T00:00:00Z", (time_t)-1 },
+	{ "2002-09-10T24:00:00Z", (time_t)-1 },
+	{ "2002-09-10 23:41:07Z", (time_t)-1 },
+	{ "2002-09-10T23:41:07.Z", (time_t)-1 },
+	{ "2002-09-10T23:41:07+24:00", (time_t)-1 },
+	{ "2002-09-10T23:41:07+05:30x", (time_t)-1 },
+	{ "2002-9-10T23:41:07Z", (time_t)-1 },
+	{ "", (time_t)-1 },
+	{ NULL, 0 }
+};
+
+static void
+print_bench(const char *name, gint64 start, int count)
+{
+	char *ns, *calls;
+
+	ns = g_strdup_printf("%.1f",
+	    (g_get_monotonic_time() - start) * 1000.0 / count);
+	calls = g_strdup_printf("%d", count);
+	printformat_module(MODULE_NAME, NULL, NULL, MSGLEVEL_CLIENTCRAP,
+	    XMPPTXT_BENCH, name, ns, calls);
+	g_free(ns);
+	g_free(calls);
+}
+
+static void
+bench_recode(int count)
+{
+	char *str;
+	gint64 start;
+	int i, n;
+
+	/* what every outgoing text used to go through */
+	start = g_get_monotonic_time();
+	for (i = n = 0; n < count; ++i, ++n) {
+		if (bench_bodies[i] == NULL)
+			i = 0;
+		str = NULL;
+		signal_emit("xmpp formats strip codes", 2, bench_bodies[i],
+		    &str);
+		g_free(str);
+	}
+	print_bench("strip codes", start, count);
+	/* the pre-scan, stripping only when needed */
+	start = g_get_monotonic_time();
+	for (i = n = 0; n < count; ++i, ++n) {
+		if (bench_bodies[i] == NULL)
+			i = 0;
+		g_free(xmpp_recode_out(bench_bodies[i]));
+	}
+	print_bench("xmpp_recode_out", start, count);
+}
+
+static void
+bench_datetime(int count)
+{
+	char *t, *expected, *passed, *total;
+	gint64 start;
+	int i, n, failed;
+
+	for (i = failed = 0; datetime_cases[i].stamp != NULL; ++i) {
+		if (xep82_datetime(datetime_cases[i].stamp)
+		    == datetime_cases[i].t)
+			continue;
+		t = g_strdup_printf("%ld",
+		    (long)xep82_datetime(datetime_cases[i].stamp));
+		expected = g_strdup_printf("%ld", (long)datetime_cases[i].t);
+		printformat_module(MODULE_NAME, NULL, NULL,
+		    MSGLEVEL_CLIENTCRAP, XMPPTXT_BENCH_MISMATCH,
+		    datetime_cases[i].stamp, t, expected);
+		g_free(t);
+		g_free(expected);
+		failed++;
+	}
+	passed = g_strdup_printf("%d", i - failed);
+	total = g_strdup_printf("%d", i);
+	printformat_module(MODULE_NAME, NULL, NULL, MSGLEVEL_CLIENTCRAP,
+	    XMPPTXT_BENCH_CHECKS, "xep82_datetime", passed, total);
+	g_free(passed);
+	g_free(total);
+	start = g_get_monotonic_time();
+	for (i = n = 0; n < count; ++i, ++n) {
+		if (datetime_cases[i].stamp == NULL)
+			i = 0;
+		xep82_datetime(datetime_cases[i].stamp);
+	}
+	print_bench("xep82_datetime", start, count);
+}
+
+/* SYNTAX: XMPPBENCH [-count <count>] recode|datetime */
+static void
+cmd_xmppbench(const char *data)
+{
+	GHashTable *optlist;
+	char *what, *str;
+	void *free_arg;
+	int count;
+
+	if (!cmd_get_params(data, &free_arg, 1 | PARAM_FLAG_OPTIONS,
+	    "xmppbench", &optlist, &what))
+		return;
+	count = (str = g_hash_table_lookup(optlist, "count")) != NULL ?
+	    atoi(str) : BENCH_COUNT;
+	if (count <= 0)
+		cmd_param_error(CMDERR_INVALID_ARGUMENT);
+	if (g_ascii_strcasecmp(what, "recode") == 0)
+		bench_recode(count);
+	else if (g_ascii_strcasecmp(what, "datetime") == 0)
+		bench_datetime(count);
+	else if (*what == '\0')
+		cmd_param_error(CMDERR_NOT_ENOUGH_PARAMS);
+	else
+		cmd_param_error(CMDERR_INVALID_ARGUMENT);
+	cmd_params_free(free_arg);
+}
+
+void
+fe_bench_init(void)
+{
+	command_bind("xmppbench", NULL, (SIGNAL_FUNC)cmd_xmppbench);
+	command_set_options("xmppbench", "@count");
+}
+
+void
+fe_bench_deinit(void)
+{
+	command_unbind("xmppbench", (SIGNAL_FUNC)cmd_xmppbench);
+}
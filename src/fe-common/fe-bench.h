@@ -0,0 +1,9 @@
+#ifndef __FE_BENCH_H
+#define __FE_BENCH_H
+
+__BEGIN_DECLS
+void fe_bench_init(void);
+void fe_bench_deinit(void);
+__END_DECLS
+
+#endif
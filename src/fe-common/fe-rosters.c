@@ -15,10 +15,12 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <stdlib.h>
 #include <string.h>
 
 #include "module.h"
 #include "levels.h"
+#include "misc.h"
 #include "module-formats.h"
 #include "printtext.h"
 #include "settings.h"
@@ -28,6 +30,32 @@
 #include "rosters-tools.h"
 #include "fe-xmpp-status.h"
 
+/* number of lines printed per main loop iteration */
+#define ROSTER_CHUNK	100
+/* the page size of "-page" when xmpp_roster_page_size is 0 */
+#define ROSTER_PAGE_SIZE	50
+
+/* a contact, or a group if group isn't NULL */
+struct roster_line {
+	char	*group;
+	char	*show;
+	char	*name;
+	char	*resources;
+	char	*subscription;
+};
+
+struct roster_output {
+	XMPP_SERVER_REC	*server;
+	GSList		*lines;
+	int		 page;
+	int		 pages;
+	int		 tag;
+};
+
+/* formatted contacts, keyed by XMPP_ROSTER_USER_REC */
+static GHashTable *user_lines;
+static GSList *outputs;
+
 static gboolean
 user_is_shown(XMPP_ROSTER_USER_REC *user)
 {
@@ -40,16 +68,6 @@ user_is_shown(XMPP_ROSTER_USER_REC *user)
 	    || settings_get_bool("xmpp_roster_show_offline")));
 }
 
-static void
-show_group(XMPP_SERVER_REC *server, XMPP_ROSTER_GROUP_REC *group)
-{
-	g_return_if_fail(IS_SERVER(server));
-	g_return_if_fail(group != NULL);
-	printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
-	    XMPPTXT_ROSTER_GROUP, (group->name != NULL) ?
-	    group->name : settings_get_str("xmpp_roster_default_group"));
-}
-
 static int
 get_first_show(GSList *list)
 {
@@ -95,38 +113,80 @@ get_resources(XMPP_SERVER_REC *server, GSList *list)
 	return text;
 }
 
-static void
-show_user(XMPP_SERVER_REC *server, XMPP_ROSTER_USER_REC *user)
+static struct roster_line *
+format_user(XMPP_SERVER_REC *server, XMPP_ROSTER_USER_REC *user)
 {
-	const char *first_show;
-	char *name, *resources, *subscription;
+	struct roster_line *line;
 	int show;
 
-	g_return_if_fail(IS_SERVER(server));
-	g_return_if_fail(user != NULL);
 	if (user->resources == NULL)
 		show = user->error ?
 		    XMPP_PRESENCE_ERROR : XMPP_PRESENCE_UNAVAILABLE;
 	else
 		show = get_first_show(user->resources);
-	first_show = format_get_text(MODULE_NAME, NULL, server, NULL,
+	line = g_new0(struct roster_line, 1);
+	line->show = format_get_text(MODULE_NAME, NULL, server, NULL,
 	    fe_xmpp_presence_show_format[show], fe_xmpp_presence_show[show]);
-	name = user->name != NULL ?
+	line->name = user->name != NULL ?
 	    format_get_text(MODULE_NAME, NULL, server, NULL,
 	        XMPPTXT_FORMAT_NAME, user->name, user->jid) :
 	    format_get_text(MODULE_NAME, NULL, server, NULL,
 	        XMPPTXT_FORMAT_JID, user->jid);
-	resources = get_resources(server, user->resources);
-	subscription = user->subscription == XMPP_SUBSCRIPTION_BOTH ? NULL :
-	    format_get_text(MODULE_NAME, NULL, server, NULL,
+	line->resources = get_resources(server, user->resources);
+	line->subscription = user->subscription == XMPP_SUBSCRIPTION_BOTH ?
+	    NULL : format_get_text(MODULE_NAME, NULL, server, NULL,
 	        XMPPTXT_FORMAT_SUBSCRIPTION,
 	        xmpp_subscription[user->subscription]);
-	printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
-    	    XMPPTXT_ROSTER_CONTACT, first_show, name, resources,
-	    subscription);
-	g_free(name);
-	g_free(resources);
-	g_free(subscription);
+	return line;
+}
+
+static struct roster_line *
+get_user_line(XMPP_SERVER_REC *server, XMPP_ROSTER_USER_REC *user)
+{
+	struct roster_line *line;
+
+	if ((line = g_hash_table_lookup(user_lines, user)) == NULL) {
+		line = format_user(server, user);
+		g_hash_table_insert(user_lines, user, line);
+	}
+	return line;
+}
+
+static void
+free_line(struct roster_line *line)
+{
+	g_free(line->group);
+	g_free(line->show);
+	g_free(line->name);
+	g_free(line->resources);
+	g_free(line->subscription);
+	g_free(line);
+}
+
+static struct roster_line *
+copy_line(struct roster_line *line)
+{
+	struct roster_line *copy;
+
+	copy = g_new(struct roster_line, 1);
+	copy->group = g_strdup(line->group);
+	copy->show = g_strdup(line->show);
+	copy->name = g_strdup(line->name);
+	copy->resources = g_strdup(line->resources);
+	copy->subscription = g_strdup(line->subscription);
+	return copy;
+}
+
+static void
+print_line(XMPP_SERVER_REC *server, struct roster_line *line)
+{
+	if (line->group != NULL)
+		printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
+		    XMPPTXT_ROSTER_GROUP, line->group);
+	else
+		printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
+		    XMPPTXT_ROSTER_CONTACT, line->show, line->name,
+		    line->resources, line->subscription);
 }
 
 static void
@@ -158,30 +218,169 @@ show_begin_of_roster(XMPP_SERVER_REC *server)
 }
 
 static void
-sig_roster_show(XMPP_SERVER_REC *server)
+free_output(struct roster_output *output)
+{
+	outputs = g_slist_remove(outputs, output);
+	if (output->tag != -1)
+		g_source_remove(output->tag);
+	g_slist_foreach(output->lines, (GFunc)free_line, NULL);
+	g_slist_free(output->lines);
+	g_free(output);
+}
+
+static struct roster_output *
+find_output(XMPP_SERVER_REC *server)
+{
+	GSList *tmp;
+
+	for (tmp = outputs; tmp != NULL; tmp = tmp->next)
+		if (((struct roster_output *)tmp->data)->server == server)
+			return tmp->data;
+	return NULL;
+}
+
+static int
+output_func(struct roster_output *output)
+{
+	struct roster_line *line;
+	int count;
+
+	for (count = 0; output->lines != NULL && count < ROSTER_CHUNK;
+	    ++count) {
+		line = output->lines->data;
+		output->lines = g_slist_delete_link(output->lines,
+		    output->lines);
+		print_line(output->server, line);
+		free_line(line);
+	}
+	if (output->lines != NULL)
+		return TRUE;
+	if (output->pages > 1)
+		printformat_module(MODULE_NAME, output->server, NULL,
+		    MSGLEVEL_CRAP, XMPPTXT_END_OF_ROSTER_PAGE, output->page,
+		    output->pages);
+	else
+		printformat_module(MODULE_NAME, output->server, NULL,
+		    MSGLEVEL_CRAP, XMPPTXT_END_OF_ROSTER);
+	output->tag = -1;
+	free_output(output);
+	return FALSE;
+}
+
+static gboolean
+user_matches(XMPP_ROSTER_USER_REC *user, gboolean online, const char *find)
+{
+	if (!user_is_shown(user) || (online && user->resources == NULL))
+		return FALSE;
+	return find == NULL || stristr(user->jid, find) != NULL
+	    || (user->name != NULL && stristr(user->name, find) != NULL);
+}
+
+static void
+sig_roster_show(XMPP_SERVER_REC *server, GHashTable *optlist)
 {
 	GSList *gl, *ul;
 	XMPP_ROSTER_GROUP_REC *group;
 	XMPP_ROSTER_USER_REC *user;
+	struct roster_output *output;
+	struct roster_line line;
+	const char *group_name, *only_group, *find, *str;
+	gboolean online, header;
+	int size, first, n;
 
 	g_return_if_fail(IS_XMPP_SERVER(server));
-	show_begin_of_roster(server);
+	only_group = optlist == NULL ? NULL :
+	    g_hash_table_lookup(optlist, "group");
+	find = optlist == NULL ? NULL : g_hash_table_lookup(optlist, "find");
+	online = optlist != NULL
+	    && g_hash_table_lookup(optlist, "online") != NULL;
+	if ((output = find_output(server)) != NULL)
+		free_output(output);
+	output = g_new0(struct roster_output, 1);
+	output->server = server;
+	output->tag = -1;
+	output->page = 1;
+	str = optlist == NULL ? NULL : g_hash_table_lookup(optlist, "page");
+	if (str != NULL && (output->page = atoi(str)) < 1)
+		output->page = 1;
+	size = settings_get_int("xmpp_roster_page_size");
+	if (str != NULL && size <= 0)
+		size = ROSTER_PAGE_SIZE;
+	first = size > 0 ? (output->page - 1) * size : 0;
+	/* take a snapshot of the lines of the page, the roster may change
+	 * while they are printed */
+	memset(&line, 0, sizeof(line));
+	n = 0;
 	for (gl = server->roster; gl != NULL; gl = gl->next) {
 		group = gl->data;
-		/* don't show groups with only offline users */
-		for (ul = group->users; ul != NULL
-		    && !user_is_shown(ul->data); ul = ul->next);
-		if (ul == NULL)
+		group_name = group->name != NULL ? group->name :
+		    settings_get_str("xmpp_roster_default_group");
+		if (only_group != NULL
+		    && g_ascii_strcasecmp(only_group, group_name) != 0)
 			continue;
-		show_group(server, group);
-		 for (ul = group->users; ul != NULL; ul = ul->next) {
+		/* don't show groups with only offline users */
+		header = FALSE;
+		for (ul = group->users; ul != NULL; ul = ul->next) {
 			user = ul->data;
-			if (user_is_shown(user))
-				show_user(server, user);
+			if (!user_matches(user, online, find))
+				continue;
+			if (n++ < first || (size > 0 && n > first + size))
+				continue;
+			if (!header) {
+				line.group = (char *)group_name;
+				output->lines = g_slist_prepend(output->lines,
+				    copy_line(&line));
+				header = TRUE;
+			}
+			output->lines = g_slist_prepend(output->lines,
+			    copy_line(get_user_line(server, user)));
 		}
 	}
-	printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
-	    XMPPTXT_END_OF_ROSTER);
+	output->lines = g_slist_reverse(output->lines);
+	output->pages = size > 0 ? (n + size - 1) / size : 1;
+	outputs = g_slist_prepend(outputs, output);
+	show_begin_of_roster(server);
+	/* print the first lines now and the rest when idle, so a big roster
+	 * doesn't freeze the terminal */
+	if (output_func(output))
+		output->tag = g_idle_add((GSourceFunc)output_func, output);
+}
+
+static void
+sig_presence_changed(XMPP_SERVER_REC *server, const char *full_jid)
+{
+	XMPP_ROSTER_USER_REC *user;
+
+	g_return_if_fail(IS_XMPP_SERVER(server));
+	g_return_if_fail(full_jid != NULL);
+	user = rosters_find_user(server->roster, full_jid, NULL, NULL);
+	if (user != NULL)
+		g_hash_table_remove(user_lines, user);
+}
+
+static void
+sig_user_changed(XMPP_SERVER_REC *server, XMPP_ROSTER_USER_REC *user)
+{
+	g_hash_table_remove(user_lines, user);
+}
+
+static void
+sig_server_disconnected(XMPP_SERVER_REC *server)
+{
+	struct roster_output *output;
+
+	if (!IS_XMPP_SERVER(server))
+		return;
+	/* the users of this server have been freed */
+	g_hash_table_remove_all(user_lines);
+	if ((output = find_output(server)) != NULL)
+		free_output(output);
+}
+
+static void
+sig_theme_changed(void)
+{
+	g_hash_table_remove_all(user_lines);
 }
 
 static void
@@ -293,7 +492,14 @@ sig_unsubscribed(XMPP_SERVER_REC *server, const char *jid)
 void
 fe_rosters_init(void)
 {
+	user_lines = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+	    NULL, (GDestroyNotify)free_line);
+	outputs = NULL;
 	signal_add("xmpp roster show", sig_roster_show);
+	signal_add("xmpp roster user changed", sig_user_changed);
+	signal_add("xmpp presence changed", sig_presence_changed);
+	signal_add_first("server disconnected", sig_server_disconnected);
+	signal_add("theme changed", sig_theme_changed);
 	signal_add("xmpp not in roster", sig_not_in_roster);
 	signal_add("xmpp presence subscribe", sig_subscribe);
 	signal_add("xmpp presence subscribed", sig_subscribed);
@@ -305,15 +511,23 @@ fe_rosters_init(void)
 	    "Agents/Services");
 	settings_add_bool("xmpp_roster", "xmpp_roster_show_offline", TRUE);
 	settings_add_bool("xmpp_roster", "xmpp_roster_show_unsubscribed", TRUE);
+	settings_add_int("xmpp_roster", "xmpp_roster_page_size", 0);
 }
 
 void
 fe_rosters_deinit(void)
 {
 	signal_remove("xmpp roster show", sig_roster_show);
+	signal_remove("xmpp roster user changed", sig_user_changed);
+	signal_remove("xmpp presence changed", sig_presence_changed);
+	signal_remove("server disconnected", sig_server_disconnected);
+	signal_remove("theme changed", sig_theme_changed);
 	signal_remove("xmpp not in roster",  sig_not_in_roster);
 	signal_remove("xmpp presence subscribe", sig_subscribe);
 	signal_remove("xmpp presence subscribed", sig_subscribed);
 	signal_remove("xmpp presence unsubscribe", sig_unsubscribe);
 	signal_remove("xmpp presence unsubscribed", sig_unsubscribed);
+	while (outputs != NULL)
+		free_output(outputs->data);
+	g_hash_table_destroy(user_lines);
 }
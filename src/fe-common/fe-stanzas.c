@@ -15,9 +15,12 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "module.h"
+#include "commands.h"
 #include "levels.h"
 #include "module-formats.h"
 #include "printtext.h"
@@ -26,14 +29,156 @@
 #include "window-items.h"
 
 #include "xmpp-servers.h"
+#include "xmpp-commands.h"
+#include "stanzas.h"
+
+#define RECORD_ALIGN(size)	(((size) + 7) & ~(gsize)7)
+
+/*
+ * Every stanza sent or received is copied into a fixed size buffer per
+ * server, the oldest records being overwritten. Records never wrap: when
+ * one doesn't fit at the end of the buffer, writing continues at the
+ * beginning and "wrap" marks where the data stops.
+ */
+struct xml_record {
+	gsize	 size;		/* aligned size of the whole record */
+	time_t	 time;
+	int	 out;
+	gsize	 len;
+	char	 text[1];
+};
+
+struct xml_ring {
+	XMPP_SERVER_REC	*server;
+	WINDOW_REC	*console;
+	char		*buf;
+	gsize		 size;
+	gsize		 first;
+	gsize		 last;
+	gsize		 wrap;
+	guint		 count;
+};
+
+static GSList *rings;
+
+static struct xml_ring *
+ring_find(XMPP_SERVER_REC *server)
+{
+	GSList *tmp;
+
+	for (tmp = rings; tmp != NULL; tmp = tmp->next)
+		if (((struct xml_ring *)tmp->data)->server == server)
+			return tmp->data;
+	return NULL;
+}
+
+static void
+ring_clear(struct xml_ring *ring)
+{
+	ring->first = ring->last = 0;
+	ring->wrap = ring->size;
+	ring->count = 0;
+}
+
+static struct xml_ring *
+ring_get(XMPP_SERVER_REC *server)
+{
+	struct xml_ring *ring;
+	gsize size;
+	int kb;
+
+	kb = settings_get_int("xmpp_xml_buffer_size");
+	size = kb > 0 ? (gsize)kb * 1024 : 0;
+	if ((ring = ring_find(server)) != NULL) {
+		if (ring->size == size)
+			return ring;
+		/* resized: start again */
+		g_free(ring->buf);
+	} else {
+		ring = g_new0(struct xml_ring, 1);
+		ring->server = server;
+		rings = g_slist_prepend(rings, ring);
+	}
+	ring->size = size;
+	ring->buf = size > 0 ? g_malloc(size) : NULL;
+	ring_clear(ring);
+	return ring;
+}
+
+static void
+ring_destroy(struct xml_ring *ring)
+{
+	rings = g_slist_remove(rings, ring);
+	g_free(ring->buf);
+	g_free(ring);
+}
+
+static void
+ring_make_room(struct xml_ring *ring, gsize size)
+{
+	struct xml_record *rec;
+
+	for (;;) {
+		if (ring->count == 0) {
+			ring_clear(ring);
+			return;
+		}
+		if (ring->last > ring->first) {
+			/* data in [first, last) */
+			if (ring->size - ring->last >= size)
+				return;
+			ring->wrap = ring->last;
+			ring->last = 0;
+		} else {
+			/* data in [first, wrap) and [0, last) */
+			if (ring->first - ring->last >= size)
+				return;
+			rec = (struct xml_record *)(ring->buf + ring->first);
+			ring->first += rec->size;
+			ring->count--;
+			if (ring->first >= ring->wrap) {
+				ring->first = 0;
+				ring->wrap = ring->size;
+			}
+		}
+	}
+}
+
+static void
+ring_add(struct xml_ring *ring, const char *msg, int out)
+{
+	struct xml_record *rec;
+	gsize len, size, max;
+
+	len = strlen(msg);
+	/* keep some room for the other records */
+	max = ring->size / 4;
+	size = RECORD_ALIGN(G_STRUCT_OFFSET(struct xml_record, text) + len + 1);
+	if (size > max) {
+		size = max & ~(gsize)7;
+		len = size - G_STRUCT_OFFSET(struct xml_record, text) - 1;
+	}
+	ring_make_room(ring, size);
+	rec = (struct xml_record *)(ring->buf + ring->last);
+	rec->size = size;
+	rec->time = time(NULL);
+	rec->out = out;
+	rec->len = len;
+	memcpy(rec->text, msg, len);
+	rec->text[len] = '\0';
+	ring->last += size;
+	ring->count++;
+}
 
 static WINDOW_REC *
-get_console(XMPP_SERVER_REC *server)
+get_console(XMPP_SERVER_REC *server, struct xml_ring *ring)
 {
 	WINDOW_REC *window;
 	char *name;
 
 	g_return_val_if_fail(IS_XMPP_SERVER(server), NULL);
+	if (ring != NULL && ring->console != NULL)
+		return ring->console;
 	name = g_strconcat("(raw:", (server->connrec->chatnet == NULL ||
 	    *server->connrec->chatnet == '\0') ? server->jid :
 	    server->connrec->chatnet, ")", (void *)NULL);
@@ -43,47 +188,208 @@ get_console(XMPP_SERVER_REC *server)
 		window_change_server(window, server);
 	}
 	g_free(name);
+	if (ring != NULL)
+		ring->console = window;
 	return window;
 }
 
 static void
-sig_xml_in(XMPP_SERVER_REC *server, const char *msg)
+print_record(WINDOW_REC *window, const char *msg, gsize len, int out)
 {
+	char *str;
+
+	str = g_strdup_printf("%lu", (unsigned long)len);
+	printformat_module_window(MODULE_NAME, window, MSGLEVEL_CRAP,
+	    out ? XMPPTXT_RAW_OUT_HEADER : XMPPTXT_RAW_IN_HEADER, str);
+	g_free(str);
+	printformat_module_window(MODULE_NAME, window, MSGLEVEL_CRAP,
+	    XMPPTXT_RAW_MESSAGE, msg);
+}
+
+static void
+xml_captured(XMPP_SERVER_REC *server, const char *msg, int out)
+{
+	struct xml_ring *ring;
 	WINDOW_REC *window;
-	char *len;
 
-	if (!settings_get_bool("xmpp_xml_console"))
-		return;
 	g_return_if_fail(IS_XMPP_SERVER(server));
 	g_return_if_fail(msg != NULL);
-	if ((window = get_console(server)) != NULL) {
-		len = g_strdup_printf("%lu", (unsigned long)strlen(msg));
-		printformat_module_window(MODULE_NAME, window, MSGLEVEL_CRAP,
-		    XMPPTXT_RAW_IN_HEADER, len);
-		g_free(len);
-		printformat_module_window(MODULE_NAME, window, MSGLEVEL_CRAP,
-		    XMPPTXT_RAW_MESSAGE, msg);
-	}
+	ring = ring_get(server);
+	if (ring->size > 0)
+		ring_add(ring, msg, out);
+	if (!settings_get_bool("xmpp_xml_console"))
+		return;
+	if ((window = get_console(server, ring)) != NULL)
+		print_record(window, msg, strlen(msg), out);
+}
+
+static void
+sig_xml_in(XMPP_SERVER_REC *server, const char *msg)
+{
+	xml_captured(server, msg, FALSE);
 }
 
 static void
 sig_xml_out(XMPP_SERVER_REC *server, const char *msg)
 {
+	xml_captured(server, msg, TRUE);
+}
+
+static gboolean
+record_match(struct xml_record *rec, int dir, const char *type,
+    const char *xmlns, const char *grep)
+{
+	gsize len;
+	char *str;
+	gboolean found;
+
+	if (dir != -1 && rec->out != dir)
+		return FALSE;
+	if (type != NULL) {
+		len = strlen(type);
+		if (rec->text[0] != '<' || strncmp(rec->text + 1, type, len) != 0
+		    || (rec->text[len + 1] != ' ' && rec->text[len + 1] != '/'
+		    && rec->text[len + 1] != '>'))
+			return FALSE;
+	}
+	if (xmlns != NULL) {
+		str = g_strconcat("xmlns=\"", xmlns, "\"", (void *)NULL);
+		found = strstr(rec->text, str) != NULL;
+		g_free(str);
+		if (!found) {
+			str = g_strconcat("xmlns='", xmlns, "'", (void *)NULL);
+			found = strstr(rec->text, str) != NULL;
+			g_free(str);
+		}
+		if (!found)
+			return FALSE;
+	}
+	return grep == NULL || strstr(rec->text, grep) != NULL;
+}
+
+/* SYNTAX: XMPPCONSOLE [-in | -out] [-type <element>] [-xmlns <namespace>]
+ *                     [-grep <text>] [-count <n>] [-page <n>] [-clear] */
+static void
+cmd_xmppconsole(const char *data, XMPP_SERVER_REC *server)
+{
+	GHashTable *optlist;
+	struct xml_ring *ring;
+	struct xml_record *rec, **matches;
 	WINDOW_REC *window;
-	char *len;
+	const char *type, *xmlns, *grep, *str;
+	char *page_str, *total_str, *shown_str;
+	gsize off;
+	guint i, n, from, to;
+	int dir, count, page;
+	void *free_arg;
 
-	if (!settings_get_bool("xmpp_xml_console"))
+	CMD_XMPP_SERVER(server);
+	if (!cmd_get_params(data, &free_arg, PARAM_FLAG_OPTIONS,
+	    "xmppconsole", &optlist))
 		return;
-	g_return_if_fail(IS_XMPP_SERVER(server));
-	g_return_if_fail(msg != NULL);
-	if ((window = get_console(server)) != NULL) {
-		len = g_strdup_printf("%lu", (unsigned long)strlen(msg));
-		printformat_module_window(MODULE_NAME, window, MSGLEVEL_CRAP,
-		    XMPPTXT_RAW_OUT_HEADER, len);
-		g_free(len);
-		printformat_module_window(MODULE_NAME, window, MSGLEVEL_CRAP,
-		    XMPPTXT_RAW_MESSAGE, msg);
+	if ((ring = ring_find(server)) == NULL || ring->count == 0) {
+		cmd_params_free(free_arg);
+		return;
+	}
+	if (g_hash_table_lookup(optlist, "clear") != NULL) {
+		ring_clear(ring);
+		cmd_params_free(free_arg);
+		return;
+	}
+	dir = g_hash_table_lookup(optlist, "in") != NULL ? FALSE :
+	    g_hash_table_lookup(optlist, "out") != NULL ? TRUE : -1;
+	type = g_hash_table_lookup(optlist, "type");
+	xmlns = g_hash_table_lookup(optlist, "xmlns");
+	grep = g_hash_table_lookup(optlist, "grep");
+	count = (str = g_hash_table_lookup(optlist, "count")) != NULL ?
+	    atoi(str) : 20;
+	page = (str = g_hash_table_lookup(optlist, "page")) != NULL ?
+	    atoi(str) : 1;
+	if (count <= 0 || page <= 0)
+		cmd_param_error(CMDERR_NOT_GOOD_IDEA);
+	/* nothing is formatted until here */
+	matches = g_new(struct xml_record *, ring->count);
+	n = 0;
+	for (i = 0, off = ring->first; i < ring->count; ++i) {
+		if (off >= ring->wrap)
+			off = 0;
+		rec = (struct xml_record *)(ring->buf + off);
+		if (record_match(rec, dir, type, xmlns, grep))
+			matches[n++] = rec;
+		off += rec->size;
 	}
+	/* page 1 holds the most recent stanzas */
+	to = (guint)(page - 1) * count < n ? n - (page - 1) * count : 0;
+	from = to > (guint)count ? to - count : 0;
+	window = get_console(server, ring);
+	for (i = from; i < to; ++i)
+		print_record(window, matches[i]->text, matches[i]->len,
+		    matches[i]->out);
+	page_str = g_strdup_printf("%d", page);
+	shown_str = g_strdup_printf("%u", to - from);
+	total_str = g_strdup_printf("%u", n);
+	printformat_module_window(MODULE_NAME, window, MSGLEVEL_CRAP,
+	    XMPPTXT_RAW_CONSOLE_PAGE, shown_str, total_str, page_str);
+	g_free(page_str);
+	g_free(shown_str);
+	g_free(total_str);
+	g_free(matches);
+	cmd_params_free(free_arg);
+}
+
+static void
+sig_flood(XMPP_SERVER_REC *server, const char *jid, gpointer dropped)
+{
+	printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
+	    XMPPTXT_FLOOD, jid, GPOINTER_TO_INT(dropped));
+}
+
+/* SYNTAX: XMPPFLOOD */
+static void
+cmd_xmppflood(const char *data, XMPP_SERVER_REC *server)
+{
+	GHashTableIter iter;
+	XMPP_FLOOD_REC *bucket;
+	char *total;
+
+	CMD_XMPP_SERVER(server);
+	if (server->flood_buckets != NULL) {
+		g_hash_table_iter_init(&iter, server->flood_buckets);
+		while (g_hash_table_iter_next(&iter, NULL,
+		    (gpointer *)&bucket))
+			if (bucket->total > 0)
+				printformat_module(MODULE_NAME, server, NULL,
+				    MSGLEVEL_CRAP, XMPPTXT_FLOOD_SENDER,
+				    bucket->jid, bucket->total);
+	}
+	total = g_strdup_printf("%lu", server->flood_dropped);
+	printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
+	    XMPPTXT_END_OF_FLOOD, total);
+	g_free(total);
+}
+
+static void
+sig_window_destroyed(WINDOW_REC *window)
+{
+	GSList *tmp;
+	struct xml_ring *ring;
+
+	for (tmp = rings; tmp != NULL; tmp = tmp->next) {
+		ring = tmp->data;
+		if (ring->console == window)
+			ring->console = NULL;
+	}
+}
+
+static void
+sig_server_destroyed(XMPP_SERVER_REC *server)
+{
+	struct xml_ring *ring;
+
+	if (!IS_XMPP_SERVER(server))
+		return;
+	if ((ring = ring_find(server)) != NULL)
+		ring_destroy(ring);
 }
 
 void
@@ -91,8 +397,17 @@ fe_stanzas_init(void)
 {
 	signal_add("xmpp xml in", (SIGNAL_FUNC)sig_xml_in);
 	signal_add("xmpp xml out", (SIGNAL_FUNC)sig_xml_out);
+	signal_add("window destroyed", (SIGNAL_FUNC)sig_window_destroyed);
+	signal_add("server destroyed", (SIGNAL_FUNC)sig_server_destroyed);
+	signal_add("xmpp flood", (SIGNAL_FUNC)sig_flood);
+	command_bind_xmpp("xmppconsole", NULL,
+	    (SIGNAL_FUNC)cmd_xmppconsole);
+	command_bind_xmpp("xmppflood", NULL, (SIGNAL_FUNC)cmd_xmppflood);
+	command_set_options("xmppconsole",
+	    "in out clear -type -xmlns -grep @count @page");
 
 	settings_add_bool("xmpp_lookandfeel", "xmpp_xml_console", FALSE);
+	settings_add_int("xmpp_lookandfeel", "xmpp_xml_buffer_size", 256);
 }
 
 void
@@ -100,4 +415,11 @@ fe_stanzas_deinit(void)
 {
 	signal_remove("xmpp xml in", (SIGNAL_FUNC)sig_xml_in);
 	signal_remove("xmpp xml out", (SIGNAL_FUNC)sig_xml_out);
+	signal_remove("window destroyed", (SIGNAL_FUNC)sig_window_destroyed);
+	signal_remove("server destroyed", (SIGNAL_FUNC)sig_server_destroyed);
+	signal_remove("xmpp flood", (SIGNAL_FUNC)sig_flood);
+	command_unbind("xmppconsole", (SIGNAL_FUNC)cmd_xmppconsole);
+	command_unbind("xmppflood", (SIGNAL_FUNC)cmd_xmppflood);
+	while (rings != NULL)
+		ring_destroy(rings->data);
 }
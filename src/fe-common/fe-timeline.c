@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdio.h>
+
+#include "module.h"
+#include "commands.h"
+#include "levels.h"
+#include "misc.h"
+#include "module-formats.h"
+#include "printtext.h"
+#include "signals.h"
+
+#include "xmpp-servers.h"
+#include "xmpp-commands.h"
+#include "timeline.h"
+
+static void
+json_append_string(GString *str, const char *s)
+{
+	g_string_append_c(str, '"');
+	for (; *s != '\0'; ++s) {
+		if (*s == '"' || *s == '\\')
+			g_string_append_printf(str, "\\%c", *s);
+		else if ((unsigned char)*s < 0x20)
+			g_string_append_printf(str, "\\u%04x", *s);
+		else
+			g_string_append_c(str, *s);
+	}
+	g_string_append_c(str, '"');
+}
+
+static char *
+timeline_json(XMPP_SERVER_REC *server, GSList *marks)
+{
+	GString *str;
+	GSList *tmp;
+	XMPP_TIMELINE_REC *mark, *first;
+	char *ret;
+
+	str = g_string_new("{\"server\":");
+	json_append_string(str, server->jid);
+	g_string_append(str, ",\"phases\":[");
+	first = marks->data;
+	for (tmp = marks; tmp != NULL; tmp = tmp->next) {
+		mark = tmp->data;
+		if (tmp != marks)
+			g_string_append_c(str, ',');
+		g_string_append(str, "{\"phase\":");
+		json_append_string(str, mark->phase);
+		g_string_append_printf(str, ",\"ms\":%.3f}",
+		    (mark->time - first->time) / 1000.0);
+	}
+	g_string_append(str, "]}");
+	ret = str->str;
+	g_string_free(str, FALSE);
+	return ret;
+}
+
+static void
+print_timeline(XMPP_SERVER_REC *server, GSList *marks)
+{
+	GSList *tmp;
+	XMPP_TIMELINE_REC *mark, *first, *prev;
+	char *total, *delta;
+
+	printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
+	    XMPPTXT_TIMELINE, server->jid);
+	first = prev = marks->data;
+	for (tmp = marks; tmp != NULL; tmp = tmp->next) {
+		mark = tmp->data;
+		total = g_strdup_printf("%ld",
+		    (long)((mark->time - first->time) / 1000));
+		delta = g_strdup_printf("%ld",
+		    (long)((mark->time - prev->time) / 1000));
+		printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
+		    XMPPTXT_TIMELINE_PHASE, total, delta, mark->phase);
+		g_free(total);
+		g_free(delta);
+		prev = mark;
+	}
+	printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
+	    XMPPTXT_END_OF_TIMELINE);
+}
+
+/* SYNTAX: XMPPTIMELINE [-json [<file>]] */
+static void
+cmd_xmpptimeline(const char *data, XMPP_SERVER_REC *server)
+{
+	GHashTable *optlist;
+	GSList *marks;
+	FILE *f;
+	char *path, *fname, *json;
+	void *free_arg;
+
+	CMD_XMPP_SERVER(server);
+	if (!cmd_get_params(data, &free_arg, 1 | PARAM_FLAG_OPTIONS,
+	    "xmpptimeline", &optlist, &path))
+		return;
+	if (server->timeline == NULL) {
+		cmd_params_free(free_arg);
+		return;
+	}
+	marks = g_slist_reverse(g_slist_copy(server->timeline));
+	if (g_hash_table_lookup(optlist, "json") == NULL) {
+		print_timeline(server, marks);
+		g_slist_free(marks);
+		cmd_params_free(free_arg);
+		return;
+	}
+	json = timeline_json(server, marks);
+	g_slist_free(marks);
+	if (*path == '\0') {
+		printformat_module(MODULE_NAME, server, NULL, MSGLEVEL_CRAP,
+		    XMPPTXT_RAW_MESSAGE, json);
+		g_free(json);
+		cmd_params_free(free_arg);
+		return;
+	}
+	fname = convert_home(path);
+	f = fopen(fname, "w");
+	g_free(fname);
+	if (f == NULL) {
+		g_free(json);
+		cmd_param_error(CMDERR_ERRNO);
+	}
+	fprintf(f, "%s\n", json);
+	fclose(f);
+	g_free(json);
+	cmd_params_free(free_arg);
+}
+
+void
+fe_timeline_init(void)
+{
+	command_bind_xmpp("xmpptimeline", NULL,
+	    (SIGNAL_FUNC)cmd_xmpptimeline);
+	command_set_options("xmpptimeline", "json");
+}
+
+void
+fe_timeline_deinit(void)
+{
+	command_unbind("xmpptimeline", (SIGNAL_FUNC)cmd_xmpptimeline);
+}
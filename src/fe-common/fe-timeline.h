@@ -0,0 +1,9 @@
+#ifndef __FE_TIMELINE_H
+#define __FE_TIMELINE_H
+
+__BEGIN_DECLS
+void fe_timeline_init(void);
+void fe_timeline_deinit(void);
+__END_DECLS
+
+#endif
@@ -29,8 +29,10 @@
 #include "fe-xmpp-queries.h"
 #include "fe-xmpp-status.h"
 #include "fe-xmpp-windows.h"
+#include "fe-bench.h"
 #include "fe-rosters.h"
 #include "fe-stanzas.h"
+#include "fe-timeline.h"
 #include "xmpp-completion.h"
 #include "xmpp-formats.h"
 #include "xep/fe-xep.h"
@@ -66,8 +68,10 @@ fe_xmpp_init(void)
 	fe_xmpp_queries_init();
 	fe_xmpp_status_init();
 	fe_xmpp_windows_init();
+	fe_bench_init();
 	fe_rosters_init();
 	fe_stanzas_init();
+	fe_timeline_init();
 	xmpp_completion_init();
 	xmpp_formats_init();
 	fe_xep_init();
@@ -93,8 +97,10 @@ fe_xmpp_deinit(void)
 	fe_xmpp_queries_deinit();
 	fe_xmpp_status_deinit();
 	fe_xmpp_windows_deinit();
+	fe_bench_deinit();
 	fe_rosters_deinit();
 	fe_stanzas_deinit();
+	fe_timeline_deinit();
 	xmpp_completion_deinit();
 	xmpp_formats_deinit();
 	fe_xep_deinit();
@@ -92,19 +92,26 @@ fe_xmpp_status_get_window(XMPP_SERVER_REC *server)
 	return window;
 }
 
+struct presence_change {
+	XMPP_SERVER_REC	*server;
+	char		*full_jid;
+	int		 show;
+	char		*status;
+	gboolean	 online;	/* the resource was offline */
+};
+
+static GSList *pending;
+static int storm_tag;
+static gboolean coming_online;
+
 static void
-sig_presence_changed(XMPP_SERVER_REC *server, const char *full_jid,
-   int show, const char *status)
+print_presence_change(XMPP_SERVER_REC *server, WINDOW_REC *window,
+    const char *full_jid, int show, const char *status)
 {
 	XMPP_ROSTER_USER_REC *user;
-	WINDOW_REC *window;
 	const char *msg;
 	char *name;
 
-	g_return_if_fail(IS_XMPP_SERVER(server));
-	g_return_if_fail(full_jid != NULL);
-	g_return_if_fail(0 <= show && show < XMPP_PRESENCE_SHOW_LEN);	
-	window = fe_xmpp_status_get_window(server);
 	msg = fe_xmpp_presence_show[show];
 	user = rosters_find_user(server->roster, full_jid, NULL, NULL);
 	name = user != NULL && user->name != NULL ?
@@ -121,12 +128,149 @@ sig_presence_changed(XMPP_SERVER_REC *server, const char *full_jid,
 	g_free(name);
 }
 
+static void
+presence_change_free(struct presence_change *pc)
+{
+	g_free(pc->full_jid);
+	g_free(pc->status);
+	g_free(pc);
+}
+
+static void
+flush_server(XMPP_SERVER_REC *server, GSList *changes)
+{
+	WINDOW_REC *window;
+	GSList *tmp;
+	struct presence_change *pc;
+	char online[16], offline[16], changed[16];
+	int count, n_online, n_offline, n_changed;
+
+	window = fe_xmpp_status_get_window(server);
+	count = g_slist_length(changes);
+	if (count <= settings_get_int("xmpp_status_window_storm_limit")) {
+		for (tmp = changes; tmp != NULL; tmp = tmp->next) {
+			pc = tmp->data;
+			print_presence_change(server, window, pc->full_jid,
+			    pc->show, pc->status);
+		}
+		return;
+	}
+	/* a storm: one summary instead of a line per resource */
+	n_online = n_offline = n_changed = 0;
+	for (tmp = changes; tmp != NULL; tmp = tmp->next) {
+		pc = tmp->data;
+		if (pc->show == XMPP_PRESENCE_UNAVAILABLE)
+			n_offline++;
+		else if (pc->online)
+			n_online++;
+		else
+			n_changed++;
+	}
+	g_snprintf(online, sizeof(online), "%d", n_online);
+	g_snprintf(offline, sizeof(offline), "%d", n_offline);
+	g_snprintf(changed, sizeof(changed), "%d", n_changed);
+	printformat_module_window(MODULE_NAME, window,
+	    MSGLEVEL_CRAP | MSGLEVEL_MODES, XMPPTXT_PRESENCE_STORM,
+	    online, offline, changed);
+}
+
+static void
+flush_pending(void)
+{
+	GSList *tmp, *changes, *next;
+	XMPP_SERVER_REC *server;
+	struct presence_change *pc;
+
+	pending = g_slist_reverse(pending);
+	while (pending != NULL) {
+		server = ((struct presence_change *)pending->data)->server;
+		changes = NULL;
+		for (tmp = pending; tmp != NULL; tmp = next) {
+			next = tmp->next;
+			pc = tmp->data;
+			if (pc->server != server)
+				continue;
+			pending = g_slist_delete_link(pending, tmp);
+			changes = g_slist_prepend(changes, pc);
+		}
+		changes = g_slist_reverse(changes);
+		flush_server(server, changes);
+		g_slist_free_full(changes, (GDestroyNotify)presence_change_free);
+	}
+}
+
+static gboolean
+storm_timeout_func(void)
+{
+	storm_tag = 0;
+	flush_pending();
+	return FALSE;
+}
+
+/* emitted right before "xmpp presence changed" for a new resource */
+static void
+sig_presence_online(XMPP_SERVER_REC *server, const char *full_jid)
+{
+	coming_online = TRUE;
+}
+
+static void
+sig_presence_changed(XMPP_SERVER_REC *server, const char *full_jid,
+   int show, const char *status)
+{
+	struct presence_change *pc;
+	gboolean online;
+	int delay;
+
+	g_return_if_fail(IS_XMPP_SERVER(server));
+	g_return_if_fail(full_jid != NULL);
+	g_return_if_fail(0 <= show && show < XMPP_PRESENCE_SHOW_LEN);	
+	online = coming_online;
+	coming_online = FALSE;
+	if ((delay = settings_get_time("xmpp_status_window_storm_time")) <= 0) {
+		print_presence_change(server, fe_xmpp_status_get_window(server),
+		    full_jid, show, status);
+		return;
+	}
+	pc = g_new(struct presence_change, 1);
+	pc->server = server;
+	pc->full_jid = g_strdup(full_jid);
+	pc->show = show;
+	pc->status = g_strdup(status);
+	pc->online = online;
+	pending = g_slist_prepend(pending, pc);
+	if (storm_tag == 0)
+		storm_tag = g_timeout_add(delay,
+		    (GSourceFunc)storm_timeout_func, NULL);
+}
+
+static void
+sig_server_disconnected(XMPP_SERVER_REC *server)
+{
+	GSList *tmp, *next;
+	struct presence_change *pc;
+
+	if (!IS_XMPP_SERVER(server))
+		return;
+	for (tmp = pending; tmp != NULL; tmp = next) {
+		next = tmp->next;
+		pc = tmp->data;
+		if (pc->server == server) {
+			pending = g_slist_delete_link(pending, tmp);
+			presence_change_free(pc);
+		}
+	}
+}
+
 static void
 sig_setup_changed(void)
 {
+	signal_remove("xmpp presence online", sig_presence_online);
 	signal_remove("xmpp presence changed", sig_presence_changed);
-	if (settings_get_bool("xmpp_status_window"))
+	if (settings_get_bool("xmpp_status_window")) {
+		signal_add("xmpp presence online", sig_presence_online);
 		signal_add("xmpp presence changed", sig_presence_changed);
+	}
 }
 
 static void
@@ -142,18 +286,30 @@ void
 fe_xmpp_status_init(void)
 {
 	signal_add("server connecting", (SIGNAL_FUNC)sig_server_connecting);
+	signal_add("server disconnected", (SIGNAL_FUNC)sig_server_disconnected);
 	signal_add("setup changed", (SIGNAL_FUNC)sig_setup_changed);
 
 	settings_add_bool("xmpp_lookandfeel", "xmpp_status_window", FALSE);
+	settings_add_time("xmpp_lookandfeel", "xmpp_status_window_storm_time",
+	    "1s");
+	settings_add_int("xmpp_lookandfeel", "xmpp_status_window_storm_limit",
+	    10);
 
-	if (settings_get_bool("xmpp_status_window"))
+	if (settings_get_bool("xmpp_status_window")) {
+		signal_add("xmpp presence online", sig_presence_online);
 		signal_add("xmpp presence changed", sig_presence_changed);
+	}
 }
 
 void
 fe_xmpp_status_deinit(void)
 {
 	signal_remove("server connecting", sig_server_connecting);
+	signal_remove("server disconnected", sig_server_disconnected);
 	signal_remove("setup changed", sig_setup_changed);
+	signal_remove("xmpp presence online", sig_presence_online);
 	signal_remove("xmpp presence changed", sig_presence_changed);
+	if (storm_tag != 0)
+		g_source_remove(storm_tag);
+	g_slist_free_full(pending, (GDestroyNotify)presence_change_free);
 }
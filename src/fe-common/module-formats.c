@@ -50,6 +50,7 @@ FORMAT_REC fecommon_xmpp_formats[] = {
 	{ "roster_contact", "   ({hilight $0}) $1 $2 $3", 4, { 0, 0, 0, 0 } },
 	{ "begin_of_roster", "ROSTER: {nick $0} $1 $2", 3, { 0, 0, 0 } },
 	{ "end_of_roster", "End of ROSTER", 0, { 0 } },
+	{ "end_of_roster_page", "End of ROSTER, page $0 of $1", 2, { 1, 1 } },
 	{ "not_in_roster", "{nick $0}: not in the roster", 1, { 0 } },
 
 	/* ---- */
@@ -78,12 +79,19 @@ FORMAT_REC fecommon_xmpp_formats[] = {
 
 	{ "joinerror", "Cannot join to room {channel $0} {comment $1}", 2, { 0, 0 } },
 	{ "destroyerror", "Cannot destroy room {channel $0} {comment $1}", 2, { 0, 0 } },
+	{ "rejoin", "Not in room {channel $0} anymore, joining it again", 1, { 0 } },
+	{ "end_of_channel_list", "End of {channel $0} $1 list {comment $2 items}", 3, { 0, 0, 1 } },
+	{ "channel_list_error", "Cannot get the $1 list of {channel $0}: $2", 3, { 0, 0, 0 } },
+	{ "channel_storm_parts", "{channel $0}: {hilight $1} left: $2", 3, { 0, 0, 0 } },
+	{ "channel_storm_rejoins", "{channel $0}: {hilight $1} left and joined again: $2", 3, { 0, 0, 0 } },
+	{ "channel_storm_joins", "{channel $0}: {hilight $1} joined: $2", 3, { 0, 0, 0 } },
 
 	/* ---- */
 	{ NULL, "Presence", 0, { 0 } },
 
 	{ "presence_change", "$0: is now {hilight $1}", 2, { 0, 0 } },
 	{ "presence_change_reason", "$0: is now {hilight $1} {comment $2}", 3, { 0, 0, 0 } },
+	{ "presence_storm", "{hilight $0} contacts came online, {hilight $1} went offline, {hilight $2} changed their status", 3, { 0, 0, 0 } },
 
 	/* ---- */
 	{ NULL, "VCard", 0, { 0 } },
@@ -99,8 +107,18 @@ FORMAT_REC fecommon_xmpp_formats[] = {
 	{ "raw_in_header", "RECV[$0]:", 1, { 0 } },
 	{ "raw_out_header", "SEND[$0]:", 1, { 0 } },
 	{ "raw_message", "$0", 1, { 0 } },
+	{ "raw_console_page", "Shown {hilight $0} of {hilight $1} stanzas (page $2)", 3, { 0, 0, 0 } },
 	{ "default_event", "$1 $2", 3, { 0, 0, 0 } },
 	{ "default_error", "ERROR $1 $2", 3, { 0, 0, 0 } },
+	{ "timeline", "Timeline of {nick $0}:", 1, { 0 } },
+	{ "timeline_phase", "  $[-7]0 ms {comment +$1 ms} $2", 3, { 0, 0, 0 } },
+	{ "end_of_timeline", "End of TIMELINE", 0, { 0 } },
+	{ "flood", "{nick $0}: flooding, dropped {hilight $1} stanzas", 2, { 0, 1 } },
+	{ "flood_sender", "  {nick $0} $1 dropped", 2, { 0, 1 } },
+	{ "end_of_flood", "End of FLOOD, {hilight $0} stanzas dropped", 1, { 0 } },
+	{ "bench", "$0: {hilight $1} ns per call {comment $2 calls}", 3, { 0, 0, 0 } },
+	{ "bench_checks", "$0: {hilight $1} of $2 cases passed", 3, { 0, 0, 0 } },
+	{ "bench_mismatch", "  $0: {hilight $1} instead of $2", 3, { 0, 0, 0 } },
 
 	{ NULL, "Registration", 0, { 0 } },
 
@@ -29,6 +29,7 @@ enum {
 	XMPPTXT_ROSTER_CONTACT,
 	XMPPTXT_BEGIN_OF_ROSTER,
 	XMPPTXT_END_OF_ROSTER,
+	XMPPTXT_END_OF_ROSTER_PAGE,
 	XMPPTXT_NOT_IN_ROSTER,
 
 	XMPPTXT_FILL_4,
@@ -53,11 +54,18 @@ enum {
 
 	XMPPTXT_CHANNEL_JOINERROR,
 	XMPPTXT_CHANNEL_DESTROYERROR,
+	XMPPTXT_CHANNEL_REJOIN,
+	XMPPTXT_END_OF_CHANNEL_LIST,
+	XMPPTXT_CHANNEL_LIST_ERROR,
+	XMPPTXT_CHANNEL_STORM_PARTS,
+	XMPPTXT_CHANNEL_STORM_REJOINS,
+	XMPPTXT_CHANNEL_STORM_JOINS,
 
 	XMPPTXT_FILL_8,
 
 	XMPPTXT_PRESENCE_CHANGE,
 	XMPPTXT_PRESENCE_CHANGE_REASON,
+	XMPPTXT_PRESENCE_STORM,
 
 	XMPPTXT_FILL_9,
 
@@ -71,8 +79,18 @@ enum {
 	XMPPTXT_RAW_IN_HEADER,
 	XMPPTXT_RAW_OUT_HEADER,
 	XMPPTXT_RAW_MESSAGE,
+	XMPPTXT_RAW_CONSOLE_PAGE,
 	XMPPTXT_DEFAULT_EVENT,
 	XMPPTXT_DEFAULT_ERROR,
+	XMPPTXT_TIMELINE,
+	XMPPTXT_TIMELINE_PHASE,
+	XMPPTXT_END_OF_TIMELINE,
+	XMPPTXT_FLOOD,
+	XMPPTXT_FLOOD_SENDER,
+	XMPPTXT_END_OF_FLOOD,
+	XMPPTXT_BENCH,
+	XMPPTXT_BENCH_CHECKS,
+	XMPPTXT_BENCH_MISMATCH,
 
 	XMPPTXT_FILL_11,
 
@@ -0,0 +1,245 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+
+/*
+ * Grouping of the joins and parts of rooms, like the netsplits of IRC: when
+ * a MUC service restarts, the occupants leave and join again all at once.
+ * Past a few events in a room within the storm time, the joins and parts
+ * aren't printed one by one anymore but summed up at the end of the storm.
+ */
+
+#include <string.h>
+
+#include "module.h"
+#include "levels.h"
+#include "module-formats.h"
+#include "printtext.h"
+#include "settings.h"
+#include "signals.h"
+
+#include "xmpp-servers.h"
+#include "xep/muc.h"
+
+enum {
+	STORM_JOINED,
+	STORM_LEFT,
+	STORM_REJOINED
+};
+
+struct muc_storm {
+	MUC_REC		*channel;
+	GHashTable	*nicks;		/* nick -> STORM_* */
+	int		 events;
+	gboolean	 grouping;
+	int		 tag;
+};
+
+static GHashTable *storms;
+
+static void
+storm_free(struct muc_storm *storm)
+{
+	if (storm->tag != -1)
+		g_source_remove(storm->tag);
+	g_hash_table_destroy(storm->nicks);
+	g_free(storm);
+}
+
+static char *
+get_nicks(GSList *nicks, int count)
+{
+	GString *str;
+	GSList *tmp;
+	char *ret;
+	int max, n;
+
+	max = settings_get_int("xmpp_muc_storm_max_nicks");
+	str = g_string_new(NULL);
+	for (tmp = nicks, n = 0; tmp != NULL && (max <= 0 || n < max);
+	    tmp = tmp->next, ++n) {
+		if (n > 0)
+			g_string_append(str, ", ");
+		g_string_append(str, tmp->data);
+	}
+	if (n < count)
+		g_string_append_printf(str, " (+%d more)", count - n);
+	ret = str->str;
+	g_string_free(str, FALSE);
+	return ret;
+}
+
+static void
+print_nicks(MUC_REC *channel, int level, int format, GSList *nicks)
+{
+	char *count, *str;
+	int n;
+
+	if (nicks == NULL)
+		return;
+	n = g_slist_length(nicks);
+	count = g_strdup_printf("%d", n);
+	str = get_nicks(nicks, n);
+	printformat_module(MODULE_NAME, channel->server, channel->name,
+	    level, format, channel->name, count, str);
+	g_free(count);
+	g_free(str);
+}
+
+static void
+print_storm(struct muc_storm *storm)
+{
+	GHashTableIter iter;
+	GSList *nicks[3];
+	gpointer key, value;
+
+	memset(nicks, 0, sizeof(nicks));
+	g_hash_table_iter_init(&iter, storm->nicks);
+	while (g_hash_table_iter_next(&iter, &key, &value))
+		nicks[GPOINTER_TO_INT(value)] =
+		    g_slist_prepend(nicks[GPOINTER_TO_INT(value)], key);
+	print_nicks(storm->channel, MSGLEVEL_PARTS,
+	    XMPPTXT_CHANNEL_STORM_PARTS, nicks[STORM_LEFT]);
+	print_nicks(storm->channel, MSGLEVEL_JOINS | MSGLEVEL_PARTS,
+	    XMPPTXT_CHANNEL_STORM_REJOINS, nicks[STORM_REJOINED]);
+	print_nicks(storm->channel, MSGLEVEL_JOINS,
+	    XMPPTXT_CHANNEL_STORM_JOINS, nicks[STORM_JOINED]);
+	g_slist_free(nicks[STORM_JOINED]);
+	g_slist_free(nicks[STORM_LEFT]);
+	g_slist_free(nicks[STORM_REJOINED]);
+}
+
+static gboolean
+storm_timeout_func(struct muc_storm *storm)
+{
+	/* the storm is over when nothing happened during the last period */
+	if (g_hash_table_size(storm->nicks) == 0) {
+		storm->tag = -1;
+		g_hash_table_remove(storms, storm->channel);
+		return FALSE;
+	}
+	print_storm(storm);
+	g_hash_table_remove_all(storm->nicks);
+	storm->events = 0;
+	return TRUE;
+}
+
+static gboolean
+storm_event(MUC_REC *channel, const char *nick, gboolean join)
+{
+	struct muc_storm *storm;
+	gpointer value;
+	int delay;
+
+	if ((delay = settings_get_time("xmpp_muc_storm_time")) <= 0
+	    || strcmp(nick, channel->nick) == 0)
+		return FALSE;
+	if ((storm = g_hash_table_lookup(storms, channel)) == NULL) {
+		storm = g_new0(struct muc_storm, 1);
+		storm->channel = channel;
+		storm->nicks = g_hash_table_new_full(g_str_hash, g_str_equal,
+		    g_free, NULL);
+		storm->tag = g_timeout_add(delay,
+		    (GSourceFunc)storm_timeout_func, storm);
+		g_hash_table_insert(storms, channel, storm);
+	}
+	if (!storm->grouping
+	    && ++storm->events <= settings_get_int("xmpp_muc_storm_limit"))
+		return FALSE;
+	storm->grouping = TRUE;
+	if (!g_hash_table_lookup_extended(storm->nicks, nick, NULL, &value))
+		g_hash_table_insert(storm->nicks, g_strdup(nick),
+		    GINT_TO_POINTER(join ? STORM_JOINED : STORM_LEFT));
+	else if (join && GPOINTER_TO_INT(value) == STORM_LEFT)
+		g_hash_table_insert(storm->nicks, g_strdup(nick),
+		    GINT_TO_POINTER(STORM_REJOINED));
+	else if (!join && GPOINTER_TO_INT(value) == STORM_JOINED)
+		/* joined and left during the storm: nothing to show */
+		g_hash_table_remove(storm->nicks, nick);
+	else if (!join && GPOINTER_TO_INT(value) == STORM_REJOINED)
+		/* left, came back and left again: still gone */
+		g_hash_table_insert(storm->nicks, g_strdup(nick),
+		    GINT_TO_POINTER(STORM_LEFT));
+	return TRUE;
+}
+
+static void
+sig_message_join(SERVER_REC *server, const char *channame, const char *nick,
+    const char *address)
+{
+	MUC_REC *channel;
+
+	if (IS_XMPP_SERVER(server)
+	    && (channel = muc_find(server, channame)) != NULL
+	    && storm_event(channel, nick, TRUE))
+		signal_stop();
+}
+
+static void
+sig_message_part(SERVER_REC *server, const char *channame, const char *nick,
+    const char *address, const char *reason)
+{
+	MUC_REC *channel;
+
+	if (IS_XMPP_SERVER(server)
+	    && (channel = muc_find(server, channame)) != NULL
+	    && storm_event(channel, nick, FALSE))
+		signal_stop();
+}
+
+/* the modes of the joins summed up aren't printed either */
+static void
+sig_mode(MUC_REC *channel, const char *nick)
+{
+	struct muc_storm *storm;
+
+	if ((storm = g_hash_table_lookup(storms, channel)) != NULL
+	    && g_hash_table_lookup_extended(storm->nicks, nick, NULL, NULL))
+		signal_stop();
+}
+
+static void
+sig_channel_destroyed(MUC_REC *channel)
+{
+	if (IS_MUC(channel))
+		g_hash_table_remove(storms, channel);
+}
+
+void
+fe_muc_netsplit_init(void)
+{
+	storms = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL,
+	    (GDestroyNotify)storm_free);
+	signal_add_first("message join", sig_message_join);
+	signal_add_first("message part", sig_message_part);
+	signal_add_first("message xmpp muc mode", sig_mode);
+	signal_add("channel destroyed", sig_channel_destroyed);
+
+	settings_add_time("xmpp_lookandfeel", "xmpp_muc_storm_time", "2s");
+	settings_add_int("xmpp_lookandfeel", "xmpp_muc_storm_limit", 5);
+	settings_add_int("xmpp_lookandfeel", "xmpp_muc_storm_max_nicks", 10);
+}
+
+void
+fe_muc_netsplit_deinit(void)
+{
+	signal_remove("message join", sig_message_join);
+	signal_remove("message part", sig_message_part);
+	signal_remove("message xmpp muc mode", sig_mode);
+	signal_remove("channel destroyed", sig_channel_destroyed);
+	g_hash_table_destroy(storms);
+}
@@ -0,0 +1,9 @@
+#ifndef __FE_MUC_NETSPLIT_H
+#define __FE_MUC_NETSPLIT_H
+
+__BEGIN_DECLS
+void fe_muc_netsplit_init(void);
+void fe_muc_netsplit_deinit(void);
+__END_DECLS
+
+#endif
@@ -92,6 +92,13 @@ sig_destroyerror(MUC_REC *channel, const char *reason)
 	    channel->name, reason);
 }
 
+static void
+sig_rejoin(MUC_REC *channel)
+{
+	printformat_module(MODULE_NAME, channel->server, channel->name,
+	    MSGLEVEL_CRAP, XMPPTXT_CHANNEL_REJOIN, channel->name);
+}
+
 static void
 sig_nick(MUC_REC *channel, NICK_REC *nick, const char *oldnick)
 {
@@ -217,6 +224,24 @@ sig_affiliation(MUC_REC *channel, const char *jid, const char *nickname, int aff
 	g_free(mode);
 }
 
+static void
+sig_list_end(MUC_REC *channel, const char *type, gpointer count)
+{
+	g_return_if_fail(IS_MUC(channel));
+	printformat_module(MODULE_NAME, channel->server, channel->name,
+	    MSGLEVEL_CRAP, XMPPTXT_END_OF_CHANNEL_LIST, channel->name, type,
+	    GPOINTER_TO_INT(count));
+}
+
+static void
+sig_list_error(MUC_REC *channel, const char *type, const char *error)
+{
+	g_return_if_fail(IS_MUC(channel));
+	printformat_module(MODULE_NAME, channel->server, channel->name,
+	    MSGLEVEL_CRAP, XMPPTXT_CHANNEL_LIST_ERROR, channel->name, type,
+	    error);
+}
+
 struct cycle_data {
 	XMPP_SERVER_REC	*server;
 	char		*joindata;
@@ -272,11 +297,14 @@ fe_muc_init(void)
 	signal_add("xmpp invite", sig_invite);
 	signal_add("xmpp muc joinerror", sig_joinerror);
 	signal_add("xmpp muc destroyerror", sig_destroyerror);
+	signal_add("xmpp muc rejoin", sig_rejoin);
 	signal_add("message xmpp muc nick", sig_nick);
 	signal_add("message xmpp muc own_nick", sig_own_nick);
 	signal_add("message xmpp muc nick in use", sig_nick_in_use);
 	signal_add("message xmpp muc mode", sig_mode);
 	signal_add("message xmpp muc affiliation", sig_affiliation);
+	signal_add("xmpp muc list end", sig_list_end);
+	signal_add("xmpp muc list error", sig_list_error);
 	signal_add_first("command cycle", cmd_cycle);
 }
 
@@ -286,10 +314,14 @@ fe_muc_deinit(void)
 	signal_remove("xmpp invite", sig_invite);
 	signal_remove("xmpp muc joinerror", sig_joinerror);
 	signal_remove("xmpp muc destroyerror", sig_destroyerror);
+	signal_remove("xmpp muc rejoin", sig_rejoin);
 	signal_remove("message xmpp muc nick", sig_nick);
 	signal_remove("message xmpp muc own_nick", sig_own_nick);
 	signal_remove("message xmpp muc nick in use", sig_nick_in_use);
 	signal_remove("message xmpp muc mode", sig_mode);
+	signal_remove("message xmpp muc affiliation", sig_affiliation);
+	signal_remove("xmpp muc list end", sig_list_end);
+	signal_remove("xmpp muc list error", sig_list_error);
 	signal_remove("command cycle", cmd_cycle);
 }
 
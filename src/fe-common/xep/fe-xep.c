@@ -20,6 +20,7 @@
 #include "fe-composing.h"
 #include "fe-delay.h"
 #include "fe-muc.h"
+#include "fe-muc-netsplit.h"
 #include "fe-ping.h"
 #include "fe-registration.h"
 #include "fe-vcard.h"
@@ -31,6 +32,7 @@ fe_xep_init(void)
 	fe_composing_init();
 	fe_delay_init();
 	fe_muc_init();
+	fe_muc_netsplit_init();
 	fe_ping_init();
 	fe_registration_init();
 	fe_vcard_init();
@@ -43,6 +45,7 @@ fe_xep_deinit(void)
 	fe_composing_deinit();
 	fe_delay_deinit();
 	fe_muc_deinit();
+	fe_muc_netsplit_deinit();
 	fe_ping_deinit();
 	fe_registration_deinit();
 	fe_vcard_deinit();
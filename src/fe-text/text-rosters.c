@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include "module.h"
+#include "signals.h"
+#include "statusbar-item.h"
+#include "window-items.h"
+
+#include "xmpp-servers.h"
+#include "rosters-tools.h"
+
+static void
+item_counter(struct SBAR_ITEM_REC *item, int get_size_only, gboolean online)
+{
+	XMPP_SERVER_REC *server;
+	char *str;
+	int n;
+
+	server = XMPP_SERVER(active_win->active_server);
+	if (server == NULL || server->roster == NULL) {
+		if (get_size_only)
+			statusbar_item_set_size(item, 0, 0);
+		return;
+	}
+	n = online ? rosters_count_online(server, NULL) :
+	    rosters_count(server, NULL, XMPP_PRESENCE_AWAY)
+	    + rosters_count(server, NULL, XMPP_PRESENCE_XA)
+	    + rosters_count(server, NULL, XMPP_PRESENCE_DND);
+	str = g_strdup_printf(online ? "{sb %d online}" : "{sb %d away}", n);
+	statusbar_item_default_handler(item, get_size_only, str, "", FALSE);
+	g_free(str);
+}
+
+static void
+item_xmpp_online(struct SBAR_ITEM_REC *item, int get_size_only)
+{
+	item_counter(item, get_size_only, TRUE);
+}
+
+static void
+item_xmpp_away(struct SBAR_ITEM_REC *item, int get_size_only)
+{
+	item_counter(item, get_size_only, FALSE);
+}
+
+static void
+counters_update(void)
+{
+	statusbar_items_redraw("xmpp_online");
+	statusbar_items_redraw("xmpp_away");
+}
+
+void
+text_rosters_init(void)
+{
+	statusbar_item_register("xmpp_online", NULL, item_xmpp_online);
+	statusbar_item_register("xmpp_away", NULL, item_xmpp_away);
+
+	signal_add("window changed", counters_update);
+	signal_add_last("xmpp presence changed", counters_update);
+	signal_add_last("xmpp roster user changed", counters_update);
+	signal_add_last("server disconnected", counters_update);
+}
+
+void
+text_rosters_deinit(void)
+{
+	statusbar_item_unregister("xmpp_online");
+	statusbar_item_unregister("xmpp_away");
+
+	signal_remove("window changed", counters_update);
+	signal_remove("xmpp presence changed", counters_update);
+	signal_remove("xmpp roster user changed", counters_update);
+	signal_remove("server disconnected", counters_update);
+}
@@ -0,0 +1,9 @@
+#ifndef __TEXT_ROSTERS_H
+#define __TEXT_ROSTERS_H
+
+__BEGIN_DECLS
+void text_rosters_init(void);
+void text_rosters_deinit(void);
+__END_DECLS
+
+#endif
@@ -18,11 +18,13 @@
 #include "module.h"
 #include "modules.h"
 
+#include "text-rosters.h"
 #include "xep/text-xep.h"
 
 void
 text_xmpp_init(void)
 {
+	text_rosters_init();
 	text_xep_init();
 
 	module_register("xmpp", "text");
@@ -31,6 +33,7 @@ text_xmpp_init(void)
 void
 text_xmpp_deinit(void)
 {
+	text_rosters_deinit();
 	text_xep_deinit();
 }
 